@@ -1,8 +1,11 @@
 #pragma once
 #include <array>
+#include <type_traits>
+#include <utility>
 #include "lowLevelMFEM.hpp"
 
 //The number definitions
+using REAL32 = float;
 using REAL64 = double;
 using UINT64 = long unsigned;
 using INT64  = long int;
@@ -12,3 +15,21 @@ using INT64  = long int;
 
 //Pack the struct
 #define PACKSTRUCT __attribute__ ((packed))
+
+//Unevaluated (expression-template) numbers are
+//kept out of the generic templated maths functions
+//they are evaluated to their Number type first
+template<typename T> struct isExprNumber{static constexpr bool value=false;};
+template<typename T> using tNumberArg = std::enable_if_t<!isExprNumber<T>::value>;
+
+//Integral scalars (2*x, x/3) of the dual types
+//that overload both double and float, they
+//promote to double
+template<typename T> using tIntegralArg = std::enable_if_t<std::is_integral<T>::value>;
+
+//The primal (innermost scalar) value of a number,
+//used for range reduction in the templated maths
+//functions, the dual types add their own overloads
+FORCE_INLINE constexpr double primalValue(const double x){return x;};
+FORCE_INLINE constexpr float  primalValue(const float  x){return x;};
+template<typename T> using tScalarType = decltype(primalValue(std::declval<T>()));
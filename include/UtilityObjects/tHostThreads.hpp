@@ -0,0 +1,234 @@
+#pragma once
+#include "mfem.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/*****************************************\
+!
+!  Host threading backend of the batched
+!  element loops, the loop [0,n) is split
+!  into nThreads static chunks (see also
+!  tWorkStealingScheduler):
+!   -OpenMP (compiled with -fopenmp)
+!   -a persistent std::thread pool otherwise
+!    (tHostThreadPool, the workers are made
+!    once by SetNumThreads and wait on a
+!    condition variable between the loops)
+!  with a single thread (the default) the
+!  loops are the serial mfem::forall_switch
+!
+!  The loops must be race-free, i.e. every
+!  iteration writes its own entries (the
+!  scatter-adds of the elements are
+!  coloured, see tElementColouring), a
+!  loop nested in a threaded loop runs
+!  serially on its thread
+!
+!  Hybrid MPI+threads, only the main
+!  thread calls MPI (MPI_THREAD_FUNNELED)
+!
+\*****************************************/
+class tHostThreadPool
+{
+  private:
+    std::vector<std::thread> workers;
+    std::mutex mtx, runMtx;
+    std::condition_variable cvStart, cvDone;
+
+    //The current loop: fn(ctx, IT) on the
+    //team IT < nTeam, the workers still
+    //running it and its generation
+    void (*fn)(void *, const int)=NULL;
+    void *ctx=NULL;
+    int nTeam=0, nPending=0;
+    unsigned long generation=0;
+    bool stop=false;
+
+    //The loop of worker IT (>= 1)
+    void WorkerLoop(const int IT);
+
+  public:
+    //Constructor and destructor (the
+    //workers are joined at exit)
+    tHostThreadPool(){};
+    ~tHostThreadPool(){Resize(0);};
+
+    //Number of workers (without the
+    //calling thread)
+    int Size() const {return workers.size();};
+
+    //Stop and join the workers and
+    //start nWorkers new ones
+    void Resize(const int nWorkers);
+
+    //Run body(IT) for IT in [0,nT) and
+    //wait, IT=0 is the calling thread
+    template<typename BODY>
+    void Run(const int nT, BODY & body);
+};
+
+
+/*****************************************\
+!
+!  Host threads of the element loops and
+!  the per-thread state
+!
+\*****************************************/
+struct tHostThreads
+{
+  //The workers of the std::thread backend
+  static tHostThreadPool & Pool(){static tHostThreadPool pool; return pool;};
+
+  //Host threads of the element loops
+  static int & NumThreads(){static int nThreads=1; return nThreads;};
+  static int  GetNumThreads(){return NumThreads();};
+  static void SetNumThreads(const int n)
+  {
+    NumThreads() = std::max(n,1);
+#ifndef _OPENMP
+    if(Pool().Size() != NumThreads()-1) Pool().Resize(NumThreads()-1);
+#endif
+  };
+
+  //Set on the threads of a threaded loop
+  static bool & InParallel(){static thread_local bool inParallel=false; return inParallel;};
+
+  //CPU time of the calling thread (without
+  //the preemptions of oversubscribed cores)
+  static double ThreadTime()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+  };
+};
+
+/*****************************************\
+!
+!  This implements the tHostThreadPool
+!  class, a loop publishes (fn, ctx, nTeam)
+!  and bumps the generation under the
+!  lock, the workers IT < nTeam run it and
+!  the last one to finish wakes the caller
+!
+\*****************************************/
+inline void tHostThreadPool::WorkerLoop(const int IT)
+{
+  unsigned long seen=0;
+  while(true){
+    void (*fnIT)(void *, const int)=NULL;
+    void *ctxIT=NULL;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cvStart.wait(lock, [&]{return stop or (generation != seen);});
+      if(stop) return;
+      seen = generation;
+      if(IT >= nTeam) continue;
+      fnIT = fn;
+      ctxIT = ctx;
+    }
+    fnIT(ctxIT, IT);
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if(--nPending == 0) cvDone.notify_one();
+    }
+  }
+};
+
+inline void tHostThreadPool::Resize(const int nWorkers)
+{
+  std::lock_guard<std::mutex> runLock(runMtx);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cvStart.notify_all();
+  for(std::thread & worker : workers) worker.join();
+  workers.clear();
+
+  stop = false;
+  generation = 0;
+  workers.reserve(std::max(nWorkers,0));
+  for(int IT=1; IT<=nWorkers; IT++) workers.emplace_back(&tHostThreadPool::WorkerLoop, this, IT);
+};
+
+template<typename BODY>
+void tHostThreadPool::Run(const int nT, BODY & body)
+{
+  if(nT-1 > Size()) Resize(nT-1);
+  std::lock_guard<std::mutex> runLock(runMtx);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    fn  = [](void *c, const int IT){(*static_cast<BODY*>(c))(IT);};
+    ctx = &body;
+    nTeam = nT;
+    nPending = nT-1;
+    generation++;
+  }
+  cvStart.notify_all();
+  body(0);
+
+  std::unique_lock<std::mutex> lock(mtx);
+  cvDone.wait(lock, [&]{return nPending == 0;});
+};
+
+//Run fn(IT, nTeam) on (up to) nT threads
+//(IT=0 is the calling thread), the nested
+//calls of the threads run serially
+template<typename FN>
+void tHostParallel(const int nT, FN && fn)
+{
+#ifdef _OPENMP
+  #pragma omp parallel num_threads(nT)
+  {
+    tHostThreads::InParallel() = true;
+    fn(omp_get_thread_num(), omp_get_num_threads());
+    tHostThreads::InParallel() = false;
+  }
+#else
+  auto team = [&](const int IT)
+  {
+    tHostThreads::InParallel() = true;
+    fn(IT, nT);
+    tHostThreads::InParallel() = false;
+  };
+  tHostThreads::Pool().Run(nT, team);
+#endif
+};
+
+//Threaded host loop over [0,n)
+//(static chunks)
+template<typename BODY>
+void tHostForall(const int n, BODY && body)
+{
+  const int nT = std::min(tHostThreads::GetNumThreads(), n);
+  if((nT <= 1) or tHostThreads::InParallel()){
+    for(int I=0; I<n; I++) body(I);
+    return;
+  }
+  tHostParallel(nT, [&](const int IT, const int nTeam)
+  {
+    const int IStart = (long(n)*IT)/nTeam, IEnd = (long(n)*(IT+1))/nTeam;
+    for(int I=IStart; I<IEnd; I++) body(I);
+  });
+};
+
+//The batched loops, the device or the
+//(threaded) host
+template<typename BODY>
+void tForall(const bool use_dev, const int n, BODY && body)
+{
+  if(use_dev or (tHostThreads::GetNumThreads() <= 1)){
+    mfem::forall_switch(use_dev, n, body);
+  }else{
+    tHostForall(n, body);
+  }
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include "tHostThreads.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+/*****************************************\
+!
+!  Work-stealing host scheduler for loops
+!  with a heterogeneous cost per item (mixed
+!  meshes, p-variation, branching energies)
+!
+!  The items are split into contiguous
+!  chunks of about the same estimated cost
+!  (nThreads*chunksPerThread chunks, the
+!  expensive items get the small chunks),
+!  each thread gets a contiguous range of
+!  chunks in its own deque:
+!   -the owner pops from the back
+!   -an idle thread steals from the front
+!    of the other deques
+!  until every deque is empty
+!
+!  Each chunk is timed (CPU time of its
+!  thread, i.e. without the preemptions of
+!  oversubscribed cores) and the relative
+!  cost of its items (mean 1 over the loop)
+!  is blended into the estimates:
+!   cost = (1-ema).cost + ema.t_item/t_mean
+!  so the next loop is chunked on the
+!  measured costs (the costs are per item
+!  ID, i.e. loops over a subset of the
+!  items, e.g. an element list, only
+!  update their items)
+!
+\*****************************************/
+class tWorkStealingScheduler
+{
+  private:
+    //Relative cost of each item
+    std::vector<double> cost;
+    int chunksPerThread=8;
+    double ema=0.5;
+
+    //The chunks [begin,end) of the
+    //positions in the loop and their times
+    std::vector<int>    chunkOffs;
+    std::vector<double> chunkTimes;
+
+    //Per thread deques of chunks
+    struct tChunkDeque{
+      std::mutex lock;
+      std::deque<int> chunks;
+    };
+    std::vector<std::unique_ptr<tChunkDeque>> deques;
+    long nSteals=0;
+
+    //Chunk the loop on the estimated costs
+    //and deal the chunks to nT deques
+    void MakeChunks(const int n, const int *items, const int nT);
+
+    //Pop a chunk of the own deque, or
+    //steal one from the others
+    bool Pop(const int IT, int & IC);
+    bool Steal(const int IT, int & IC);
+
+    //Blend the chunk times into the costs
+    void UpdateCosts(const int n, const int *items);
+
+  public:
+    //Constructor, nItems unit costs
+    tWorkStealingScheduler(const int nItems=0): cost(nItems,1.0){};
+
+    //Reset the costs of nItems
+    void SetNItems(const int nItems){cost.assign(nItems,1.0);};
+
+    //Chunks per thread and the weight
+    //of the latest measurement
+    void SetChunking(const int chunksPerThread_, const double ema_=0.5)
+                   {chunksPerThread = std::max(chunksPerThread_,1); ema = ema_;};
+
+    //body(item) for the n items (the items
+    //list, NULL for 0..n-1)
+    template<typename BODY>
+    void Forall(const int n, const int *items, BODY && body);
+
+    //Statistics
+    const std::vector<double> & GetCosts() const {return cost;};
+    int  GetNChunks() const {return int(chunkOffs.size()) - 1;};
+    long GetNSteals() const {return nSteals;};
+};
+
+
+/*****************************************\
+!
+!  This implements the
+!  tWorkStealingScheduler class
+!
+\*****************************************/
+template<typename BODY>
+void tWorkStealingScheduler::Forall(const int n, const int *items, BODY && body)
+{
+  const int nT = std::min(tHostThreads::GetNumThreads(), n);
+  if((nT <= 1) or tHostThreads::InParallel()){
+    for(int I=0; I<n; I++) body((items == NULL)? I: items[I]);
+    return;
+  }
+
+  MakeChunks(n, items, nT);
+  std::atomic<long> steals(0);
+  tHostParallel(nT, [&](const int IT, const int)
+  {
+    int IC;
+    bool own=true;
+    while((own = Pop(IT, IC)) or Steal(IT, IC)){
+      if(not own) steals++;
+      const double t0 = tHostThreads::ThreadTime();
+      for(int I=chunkOffs[IC]; I<chunkOffs[IC+1]; I++) body((items == NULL)? I: items[I]);
+      chunkTimes[IC] = tHostThreads::ThreadTime() - t0;
+    }
+  });
+  nSteals += steals;
+  UpdateCosts(n, items);
+};
+
+inline void tWorkStealingScheduler::MakeChunks(const int n, const int *items, const int nT)
+{
+  //Contiguous chunks of about
+  //the target cost
+  double total=0.0;
+  for(int I=0; I<n; I++) total += cost[(items == NULL)? I: items[I]];
+  const double target = total/(nT*chunksPerThread);
+  chunkOffs.assign(1,0);
+  double acc=0.0;
+  for(int I=0; I<n; I++){
+    acc += cost[(items == NULL)? I: items[I]];
+    if((acc >= target) or (I == n-1)){ chunkOffs.push_back(I+1); acc=0.0;};
+  }
+  const int nChunks = int(chunkOffs.size()) - 1;
+  chunkTimes.assign(nChunks, 0.0);
+
+  //Deal contiguous ranges of chunks
+  //(about total/nT each)
+  if(int(deques.size()) < nT){
+    deques.resize(nT);
+    for(auto & dq : deques) if(not dq) dq.reset(new tChunkDeque);
+  }
+  for(int IT=0; IT<nT; IT++) deques[IT]->chunks.clear();
+  double start=0.0;
+  for(int IC=0, I=0; IC<nChunks; IC++){
+    double cChunk=0.0;
+    for(; I<chunkOffs[IC+1]; I++) cChunk += cost[(items == NULL)? I: items[I]];
+    const int IT = std::min(int(nT*(start + 0.5*cChunk)/total), nT-1);
+    deques[IT]->chunks.push_back(IC);
+    start += cChunk;
+  }
+  for(int IT=nT; IT<int(deques.size()); IT++) deques[IT]->chunks.clear();
+};
+
+inline bool tWorkStealingScheduler::Pop(const int IT, int & IC)
+{
+  tChunkDeque & dq = *deques[IT];
+  std::lock_guard<std::mutex> guard(dq.lock);
+  if(dq.chunks.empty()) return false;
+  IC = dq.chunks.back();
+  dq.chunks.pop_back();
+  return true;
+};
+
+inline bool tWorkStealingScheduler::Steal(const int IT, int & IC)
+{
+  const int nT = deques.size();
+  for(int K=1; K<nT; K++){
+    tChunkDeque & dq = *deques[(IT + K) % nT];
+    std::lock_guard<std::mutex> guard(dq.lock);
+    if(dq.chunks.empty()) continue;
+    IC = dq.chunks.front();
+    dq.chunks.pop_front();
+    return true;
+  }
+  return false;
+};
+
+inline void tWorkStealingScheduler::UpdateCosts(const int n, const int *items)
+{
+  double total=0.0;
+  for(double t : chunkTimes) total += t;
+  if(total <= 0.0) return;
+  const double tMean = total/n;
+  for(int IC=0; IC<GetNChunks(); IC++){
+    const double rel = chunkTimes[IC]/((chunkOffs[IC+1] - chunkOffs[IC])*tMean);
+    for(int I=chunkOffs[IC]; I<chunkOffs[IC+1]; I++){
+      double & c = cost[(items == NULL)? I: items[I]];
+      c = std::max((1.0 - ema)*c + ema*rel, 1e-3);
+    }
+  }
+};
@@ -1,35 +1,55 @@
-#include "../nlOperator/TCoeffInteg.hpp"
+#pragma once
+#include "../nlOperator/TQcoeffInteg.hpp"
 
 
 /*****************************************\
 !
 !  Example energy functional coefficients
 !
+!  Linear elasticity, the sampled Var is
+!  the reference gradient of the
+!  displacement du_c/dxi_d [dim x dim]:
+!   grad(u) = du/dxi.invJ
+!   eps     = (grad(u) + grad(u)^T)/2
+!   W = mu.eps:eps + lambda/2.tr(eps)^2
+!
 \*****************************************/
-template<typename Number>
-class TLElasticityCoeffIntegrator
+template<typename Number, unsigned dim>
+class TLElasticityCoeffIntegrator : public TCoefficientIntegrator<Number>
 {
   private:
-    //consts// dShapeFunc, ShapeFunc, detJ, weights
-    //Vars  // u, gradU 
-
-
-/*
-  //Element transforms etc..
-  Array<int> vdofs;
-  ElementTransformation *eltrans;
-  DofTransformation *doftrans;
-*/
-
+    Number mu, lambda;
 
   public:
-   /// Define a time-independent templated coefficient
-   TLElasticityCoeffIntegrator(Array<int> used_blocks);
-
-   /// Evaluate the integral of the element
-   Number Eval(Array<int> elm_btoffs, BlockVector elm_x)=0;
+   static constexpr unsigned nInputs = dim*dim;
 
-   /// Coefficicient destructor
-   ~TLElasticityCoeffIntegrator();
+   /// Define a time-independent templated coefficient
+   TLElasticityCoeffIntegrator(mfem::Array<int> used_blocks, unsigned integID, Number mu_, Number lambda_):
+     TCoefficientIntegrator<Number>(used_blocks, integID), mu(mu_), lambda(lambda_){};
+
+   /// Evaluate the energy density
+   template<typename T>
+   FORCE_INLINE T Eval(const T vars[], const Number coeffs[]) const
+   {
+     //Physical displacement gradient
+     const Number *invJ = coeffs + 1;
+     T gradU[dim*dim];
+     for(unsigned I=0; I<dim; I++){
+       for(unsigned J=0; J<dim; J++){
+         gradU[I*dim + J] = T(0.0);
+         for(unsigned K=0; K<dim; K++) gradU[I*dim + J] += vars[I*dim + K]*invJ[K*dim + J];
+       }
+     }
+
+     //Strain energy
+     T trEps(0.0), epsEps(0.0);
+     for(unsigned I=0; I<dim; I++){
+       trEps += gradU[I*dim + I];
+       for(unsigned J=0; J<dim; J++){
+         const T eps = 0.5*(gradU[I*dim + J] + gradU[J*dim + I]);
+         epsEps += eps*eps;
+       }
+     }
+     return mu*epsEps + (0.5*lambda)*trEps*trEps;
+   };
 };
-
@@ -0,0 +1,60 @@
+#pragma once
+#include "../nlOperator/TQcoeffInteg.hpp"
+#include "../templatedMaths/tCmath.hpp"
+
+
+/*****************************************\
+!
+!  Example energy functional coefficients
+!
+!  Compressible neo-Hookean (the same as
+!  mfem::NeoHookeanModel), the sampled Var
+!  is the reference gradient of the
+!  deformed positions dx_c/dxi_d [dim x dim]:
+!   F = dx/dxi.invJ,  J = det(F)
+!   W = mu/2.(J^(-2/dim).F:F - dim)
+!     + K/2.(J - 1)^2
+!
+\*****************************************/
+template<typename Number, unsigned dim>
+class TNeoHookeanCoeffIntegrator : public TCoefficientIntegrator<Number>
+{
+  private:
+    Number mu, K;
+
+  public:
+   static constexpr unsigned nInputs = dim*dim;
+
+   /// Define a time-independent templated coefficient
+   TNeoHookeanCoeffIntegrator(mfem::Array<int> used_blocks, unsigned integID, Number mu_, Number K_):
+     TCoefficientIntegrator<Number>(used_blocks, integID), mu(mu_), K(K_){};
+
+   /// Evaluate the energy density
+   template<typename T>
+   FORCE_INLINE T Eval(const T vars[], const Number coeffs[]) const
+   {
+     //Deformation gradient
+     const Number *invJ = coeffs + 1;
+     T F[dim*dim];
+     for(unsigned I=0; I<dim; I++){
+       for(unsigned J=0; J<dim; J++){
+         F[I*dim + J] = T(0.0);
+         for(unsigned L=0; L<dim; L++) F[I*dim + J] += vars[I*dim + L]*invJ[L*dim + J];
+       }
+     }
+
+     //Invariants
+     T detF, FF(0.0);
+     if constexpr(dim == 2){
+       detF = F[0]*F[3] - F[1]*F[2];
+     }else{
+       detF = F[0]*(F[4]*F[8] - F[5]*F[7])
+            - F[1]*(F[3]*F[8] - F[5]*F[6])
+            + F[2]*(F[3]*F[7] - F[4]*F[6]);
+     }
+     for(unsigned I=0; I<dim*dim; I++) FF += F[I]*F[I];
+
+     const T I1bar = pow<-2,int(dim)>(detF)*FF;
+     return (0.5*mu)*(I1bar - double(dim)) + (0.5*K)*(detF - 1.0)*(detF - 1.0);
+   };
+};
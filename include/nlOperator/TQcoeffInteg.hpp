@@ -12,6 +12,18 @@
 !   -Takes in a sampled Var and evaluates
 !    the energy functional.
 !
+!  Derived energies (statically) provide
+!   nInputs : number of sampled Vars at
+!             an integration point
+!   Eval    : the energy density given the
+!             sampled Vars (any Number type,
+!             e.g. dual numbers) and the
+!             geometric coefficients:
+!             [w.detJ, invJ (dim x sdim)]
+!  Eval is inlined into the batched element
+!  loop of the form (no virtual calls) so
+!  the energies must be trivially copyable
+!
 \*****************************************/
 template<typename Number>
 class TCoefficientIntegrator
@@ -26,14 +38,16 @@ class TCoefficientIntegrator
 
   public:
    /// Define a time-independent templated coefficient
-   TCoefficientIntegrator(Array<int> used_blocks, unsigned integID){};
+   TCoefficientIntegrator([[maybe_unused]] mfem::Array<int> used_blocks, unsigned integID): IntegRuleID(integID){};
 
    /// Coefficicient destructor
    ~TCoefficientIntegrator(){};
 
    /// Evaluate the integral of the element
    unsigned &GetIntegRule(){return IntegRuleID;};
+   const unsigned &GetIntegRule() const {return IntegRuleID;};
 
-   /// Evaluate the integral of the element
-   Number Eval(Array<int> InputBlocks, tVarVectorMFEM<Number,unsigned> elm_vars){return 0;};
+   /// Evaluate the energy density at an integration point
+   template<typename T>
+   FORCE_INLINE T Eval(const T vars[], const Number coeffs[]) const {return T(0.0);};
 };
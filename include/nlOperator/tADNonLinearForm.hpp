@@ -3,9 +3,18 @@
 #include "../UtilityObjects/macros.hpp"
 #include "../UtilityObjects/lowLevelMFEM.hpp"
 #include "../templatedMathObjs/dualNumber.hpp"
+#include "../templatedMathObjs/dualVecNumber.hpp"
+#include "../templatedMathObjs/dualHessNumber.hpp"
+#include "../templatedMathObjs/tapeNumber.hpp"
 #include "../templatedMathObjs/tVector.hpp"
 #include "../UtilityObjects/utilityFuncs.hpp"
+#include "../UtilityObjects/tWorkStealingScheduler.hpp"
 #include <vector>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <string>
 
 
 //Linear algebra
@@ -13,9 +22,17 @@
 #include "../templatedMathObjs/tMultiVarVector.hpp"
 #include "tInterpolator.hpp"
 #include "tRestrictOperator.hpp"
+#include "tParCSRAssembler.hpp"
+#include "tGeometricFactors.hpp"
+#include "TQcoeffInteg.hpp"
 
 template<typename Num> using dualSymNum = dualNumber<Num,Num>;
 
+//Second order number for the Jacobian, only the
+//upper triangle of the (symmetric) Hessian of the
+//energy with regards to the N inputs is propagated
+template<typename Num, unsigned N> using dualHessNum = dualHessNumber<Num,N>;
+
 /*****************************************\
 !
 ! Non-linear Form
@@ -56,50 +73,286 @@ template<typename Num> using dualSymNum = dualNumber<Num,Num>;
 ! by choice of interpolation of the discrete
 ! values of u
 !
+! Precision:
+! Number is the precision of the sampled
+! Vars/Coeffs and the energy evaluation
+! (dual propagation) at the integration
+! points, AccumNumber is the precision of
+! the element sums and the global residual
+! e.g. tADNLForm<REAL32,REAL64> evaluates
+! in float (twice the SIMD width, half the
+! sampled data traffic) and accumulates
+! in double
+!
+! Residual pipeline (Mult), each phase is
+! one batched loop over the elements:
+!  restrict    : x -> EBlockVector
+!  interpolate : EBlockVector -> xE_Samp
+!  evaluate    : de/dxE_Samp.w.detJ (dual
+!                numbers) -> rE_Samp (the
+!                energies summed in
+!                AccumNumber)
+!  transpose   : rE_Samp -> EBlockResidual
+!  scatter     : EBlockResidual -> y
+!
+! Jacobian (GetGradient), the Hessians of
+! the energies at the sample points give
+! the element matrices Q^T.D.Q (elMats)
+! which overwrite the values of a single
+! HypreParMatrix in place (the sparsity
+! pattern is built once, see
+! tParCSRAssembler)
+!
+! Assembly levels of the Jacobian:
+!  FULL    : assembled HypreParMatrix
+!  ELEMENT : the element matrices are
+!            stored [nDofsMax^2 x nElms],
+!            J.v = R^T.K_e.R.v (batched GEMV)
+!  PARTIAL : the Hessians D of the sampled
+!            Vars are stored at the points
+!            [VarSize^2 x nQuads x nElms],
+!            J.v = R^T.Q^T.D.Q.R.v
+!  NONE    : matrix-free action J.v, the
+!            sampled Vars are seeded with
+!            the sampled v (one directional
+!            derivative of the residual, no
+!            element matrices are formed)
+! SetAutoTune times every level on the
+! actual mesh and energies when the
+! operator is first prepared on a mesh
+! (Mesh::GetSequence) and keeps the
+! cheapest per Newton step
+!
+! Incremental Jacobian (localised
+! nonlinearity), the Hessians/element
+! matrices are only re-evaluated on the
+! elements whose DOF's moved more than a
+! tolerance since their last linearisation,
+! FULL patches K_new - K_old into the
+! cached local CSR values
+!
+! Host threads (tHostThreads), the point
+! loops are threaded directly and the
+! scatter-adds (restriction transpose,
+! element matrices) run colour by colour
+! over an element colouring, the energy
+! kernels are scheduled by work-stealing
+! over element chunks sized on the
+! measured element costs
+!
+! Rebalance, the energy kernels can time
+! each element (SetElementTiming), the
+! nonconforming ParMesh is repartitioned
+! on the measured costs and the TrueVars
+! are migrated with it, a conforming
+! ParMesh is repartitioned into a new
+! ParMesh (RebalancedMesh)
+!
 \*****************************************/
-template<typename Number>
+//Matrix-free Jacobian of a form, only
+//provides the action (see JacobianMult)
+template<typename Form>
+class tMFJacobian : public mfem::Operator
+{
+  private:
+    const Form & form;
+
+  public:
+    tMFJacobian(const Form & form_): mfem::Operator(form_.Height(), form_.Width()), form(form_){};
+    void Mult(const mfem::Vector & v, mfem::Vector & y) const {form.JacobianMult(v,y);};
+};
+
+template<typename Number, typename AccumNumber=mfem::real_t>
 class tADNLForm : public Operator
 {
 private:
   //Reference to essential boundary conditions
   const std::vector<ParGridFunction*> & TrueVars;
+  mfem::Array<mfem::ParFiniteElementSpace*> ParFEs;
   std::vector<mfem::Array<int>*>      ess_bcs_markers;
   mfem::Array<int>                    ess_bcs_tdofs;
 
+  //Integration rules of the energies, the Vars
+  //are sampled at the points of one rule
+  std::vector<const mfem::IntegrationRule*> IntegRules;
+  unsigned SampIntegRuleID=0;
+
   //Functions for evaluating the coefficients
   //at the at the integration points for residual
-  //and the Jacobian
+  //and the Jacobian, each is a batched kernel over
+  //the elements (sampled Vars, Coeffs) -> residual
+  //of a list of elements (NULL, every element)
 //TODO:Make a var map for Var blocks used in Jacbian forms
-  std::vector<std::function<void(const mfem::Vector         & x
-                               , const MFEMVarIterData<int> & Iter
-                               , const mfem::Array<int>     & activeBlocks)>> Rfuncs; 
+  std::vector<std::function<void(const tVectorMFEM<Number> & x
+                               , const tVectorMFEM<Number> & coeffs
+                               , tVectorMFEM<AccumNumber>  & r
+                               , const mfem::Array<int>    * elems)>> Rfuncs;
+
+
+  std::vector<std::function<void(const tVectorMFEM<Number> & x
+                               , const tVectorMFEM<Number> & coeffs
+                               , tVectorMFEM<Number>       & D
+                               , const mfem::Array<int>    * elems)>> Jfuncs;
 
+  //Energy density kernels (plain Number)
+  //(x, coeffs) -> w.detJ.e at the sample points
+  std::vector<std::function<void(const tVectorMFEM<Number> & x
+                               , const tVectorMFEM<Number> & coeffs
+                               , tVectorMFEM<AccumNumber>  & e)>> Efuncs;
 
-  std::vector<std::function<void(const Vector & x, const MFEMVarIterData<int> & Iter)>> Jfuncs; 
+  //Fused residual and Hessian kernels
+  //(x, coeffs) -> (r, D)
+  std::vector<std::function<void(const tVectorMFEM<Number> & x
+                               , const tVectorMFEM<Number> & coeffs
+                               , tVectorMFEM<AccumNumber>  & r
+                               , tVectorMFEM<Number>       & D
+                               , const mfem::Array<int>    * elems)>> RJfuncs;
+
+  //Directional derivatives of the residual
+  //(x, v, coeffs) -> J.v at the sample points
+  std::vector<std::function<void(const tVectorMFEM<Number> & x
+                               , const tVectorMFEM<Number> & v
+                               , const tVectorMFEM<Number> & coeffs
+                               , tVectorMFEM<AccumNumber>  & Jv)>> JVfuncs;
+
+  //The evaluation and accumulation precisions
+  //(the accumulation is never less precise)
+  static_assert(sizeof(AccumNumber) >= sizeof(tScalarType<Number>)
+              , "tADNLForm: AccumNumber must be at least as precise as Number");
 
   //Reference to block vector of element data
-  mutable mfem::Vector  *xE_Samp=NULL, *coeffE_Samp=NULL;        //The sampled vars and Coeffs
+  mutable tVectorMFEM<Number> *xE_Samp=NULL, *coeffE_Samp=NULL;  //The sampled vars and Coeffs (Number)
+  mutable tVectorMFEM<AccumNumber> *rE_Samp=NULL;                 //The residual of the sampled vars (AccumNumber)
+  mutable tVectorMFEM<Number> *DE_Samp=NULL;                      //The Hessian of the sampled vars
+  mutable tVectorMFEM<Number> *xLin_Samp=NULL;                    //The sampled vars at the linearisation
   mutable mfem::Vector  *EBlockVector=NULL, *EBlockResidual=NULL;//The element vectors
   mutable mfem::DenseMatrix elMats;
+  mutable mfem::Vector  *elMatsE=NULL;                            //The element matrices [nDofsMax^2 x nElms]
 
   //Used for directional derivatives Templated
   //dual number vector for Residual and Jacobian
   mutable mfem::Operator *Jacobian_f=NULL;
+  mutable tParCSRAssembler<int> *csr_assembler=NULL;
+  mutable tMFJacobian<tADNLForm> *Jacobian_mf=NULL;
+  mutable mfem::Vector vConstrained;
+  mutable mfem::AssemblyLevel assembly_level=mfem::AssemblyLevel::FULL;
+  int autotune_nKrylov=0;
+  mutable long autotune_sequence=-1;
+
+  //Incremental Jacobian, the element DOF's
+  //at the last linearisation of each element
+  //and the elements to (not) relinearise
+  mutable mfem::real_t incr_tol=-1.0;
+  mutable mfem::Vector *xERef=NULL;
+  mutable bool incr_valid=false, incr_rebuild=false;
+  mutable mfem::Array<int> activeElms, inactiveElms;
+
+  //Work-stealing scheduler of the threaded
+  //point kernels (per element costs)
+  mutable tWorkStealingScheduler scheduler;
+
+  //Reverse-mode (taped) residual kernels
+  //on the host, forward mode otherwise
+  bool reverse_mode=false;
+
+  //Accumulated evaluation times of the
+  //elements (host energy kernels)
+  bool elm_timing=false;
+  mutable std::vector<double> elmTimes;
 
   //Restriction and Interpolation operators
-  mutable mfem::Operator *elem_restrict=NULL;
+  mutable tRestrictOperator<int> *elem_restrict=NULL;
   mutable tInterpolator *IOp=NULL;
 
+  //Geometric factors of the integration
+  //rules (cached), coeffE_Samp is packed
+  //from the sampling rule when rebuilt
+  mutable tGeometricFactors *geomFactors=NULL;
+  mutable bool coeffs_valid=false;
+
   //Device and memory configs
   const bool             & use_dev;
   const mfem::Device     & device;
   const mfem::MemoryType & mt;
 
   //Problem sizing
-  int nVars=0, sum_nIps_nVars=0;
+  mutable int nVars=0, sum_nIps_nVars=0;
+  mutable int nQuads=0, nCoeffs=0, VarSize=0;
   int nElms=0, nDofsMax=0, nElmDofs=0, nEQs=0;
   int OperatorSize(const std::vector<ParGridFunction*> & TrueVars_);
 
+  //(Re)build the restriction and element
+  //vectors of the mesh partition
+  void SizeElements();
+
+  //Sample the geometric coefficients
+  //[w.detJ, invJ] at the integration points
+  //(only when the cached factors changed)
+  void SampleCoeffs() const;
+
+  //Restrict and interpolate x to the
+  //sampled Vars (and sample the Coeffs)
+  void SampleVars(const Vector & x) const;
+
+  //Sum the sampled residuals (rE_Samp)
+  //into the true DOF's
+  void ScatterSampled(Vector & y) const;
+
+  //The same for an element set of the
+  //restriction (see tRestrictOperator)
+  void SampleElements(const int ISet) const;
+  void ScatterElements(const int ISet) const;
+
+  //Residual pass x -> y, eval(elems) fills
+  //rE_Samp of the listed elements, with the
+  //halo exchanges overlapped by the interior
+  //elements (if the restriction overlaps)
+  template<typename EVAL>
+  void ResidualPass(const Vector & x, Vector & y, EVAL && eval) const;
+
+  //Batched loop over the sample points of a
+  //list of elements (NULL, every element),
+  //body(Iq) with Iq = IElm*nQuads + Ip
+  template<typename BODY>
+  void PointForall(const mfem::Array<int> *elems, BODY && body) const;
+
+  //Zero the sampled data (stride per
+  //element) of a list of elements
+  template<typename T>
+  void ZeroSampled(tVectorMFEM<T> & v, const int stride, const mfem::Array<int> *elems) const;
+
+  //The elements whose DOF's moved more than
+  //the incremental tolerance since their last
+  //linearisation (NULL, every element)
+  const mfem::Array<int> *SelectActiveElements() const;
+
+  //Evaluate the Hessians at the
+  //sample points (DE_Samp)
+  void EvaluateHessians(const mfem::Array<int> *elems) const;
+
+  //Assemble the Jacobian HypreParMatrix
+  //(from the sampled Hessians)
+  void AssembleFull(const mfem::Array<int> *elems) const;
+
+  //Build the Jacobian of the assembly level
+  //from the sampled Vars/Hessians
+  void FinishJacobian(const mfem::Array<int> *elems) const;
+
+  //(Re)allocate the Jacobian storage
+  //of the assembly level (keep_pattern
+  //keeps the FULL sparsity pattern for
+  //the other levels)
+  void AllocateJacobian(const bool keep_pattern=false) const;
+
+  //Time the assembly levels and keep the
+  //fastest (see SetAutoTune)
+  void AutoTune() const;
+
+  //The target rank of each element from the
+  //measured element times (see Rebalance),
+  //false if the ranks are balanced
+  bool WeightedPartition(const mfem::real_t imbalance_tol, mfem::Array<int> & partition) const;
+
   //Iterators for MultiVarTensor data
   mutable bool VarIterUpdateFlag=false;
   mutable VarIterData<int>     IO_VarIterator;
@@ -113,10 +366,88 @@ public:
   //Destructor
   ~tADNLForm();
 
+  //Add an integration rule, returns its ID
+  unsigned AddIntegRule(const mfem::IntegrationRule & ir);
+
   //Add a tensor variable to the list of sampled
   //variables which are sampled over every element
   //this variable has a parent True Var and an interpolator
-  void AddTVar(const Var<int> & newVar, const mfem::Operator & InterpOp);
+  //[nQuads*TVarSize x nDofsParent] (see tInterpolator)
+  void AddTVar(const Var<int> & newVar, const mfem::DenseMatrix & InterpOp);
+
+  //Add an energy functional coefficient (derived
+  //from TCoefficientIntegrator) of the sampled Vars
+  template<typename EnergyT>
+  void AddEnergy(const EnergyT & energy);
+
+  //Set the essential (constrained) true DOF's
+  void SetEssentialTrueDofs(const mfem::Array<int> & ess_tdofs){ess_tdofs.Copy(ess_bcs_tdofs);};
+
+  //Set the assembly level of the Jacobian
+  //(FULL, ELEMENT, PARTIAL or NONE, i.e. matrix-free)
+  void SetAssemblyLevel(const mfem::AssemblyLevel level);
+  mfem::AssemblyLevel GetAssemblyLevel() const {return assembly_level;};
+
+  //Pick the assembly level by timing each level
+  //on the current TrueVars when the operator is
+  //prepared, the cost of a Newton step is the
+  //Jacobian build + nKrylovIts Jacobian actions
+  void SetAutoTune(const int nKrylovIts=20);
+
+  //Incremental Jacobian (FULL, ELEMENT and
+  //PARTIAL), an element is only relinearised
+  //when one of its DOF's moved more than tol
+  //since its last linearisation (tol < 0
+  //disables it, resets the linearisation)
+  void SetIncrementalJacobian(const mfem::real_t tol);
+  int GetNumRelinearised() const {return (incr_tol < 0.0)? nElms: activeElms.Size();};
+
+  //The scheduler of the threaded energy
+  //kernels (chunking, measured costs)
+  tWorkStealingScheduler & GetScheduler() const {return scheduler;};
+
+  //The cached geometric factors, rebuilt
+  //after the mesh is refined or its nodes
+  //moved (Mesh::NodesUpdated), Invalidate
+  //forces the rebuild
+  const tGeometricFactors & GetGeometricFactors() const {return *geomFactors;};
+  void InvalidateGeometry() const {geomFactors->Invalidate();};
+
+  //Time the evaluation of each element in
+  //the energy kernels (host), the times are
+  //accumulated until it is switched on again
+  void SetElementTiming(const bool on){elm_timing = on; if(on) elmTimes.assign(nElms,0.0);};
+
+  //The residual kernels from one forward and
+  //one backward sweep of the (thread) tapes
+  //(tapeNumber) instead of the dualVecNumber
+  //lanes, host only, the Jacobian kernels
+  //stay in forward mode
+  void SetReverseMode(const bool on){reverse_mode = on;};
+  bool GetReverseMode() const {return reverse_mode;};
+  const std::vector<double> & GetElementTimes() const {return elmTimes;};
+
+  //Repartition the (nonconforming) ParMesh on
+  //the measured element times if the slowest
+  //rank exceeds imbalance_tol x the mean,
+  //migrates the TrueVars and rebuilds the
+  //form (the essential true DOF's and the
+  //true vectors must be set again), returns
+  //true if the mesh was repartitioned (a
+  //conforming ParMesh is left as it is and
+  //false returned, see RebalancedMesh)
+  bool Rebalance(const mfem::real_t imbalance_tol=1.05);
+
+  //The same global mesh as a new ParMesh
+  //with the weighted partition (a conforming
+  //ParMesh, the FE-spaces, TrueVars and the
+  //form are rebuilt on it by the caller who
+  //owns it), NULL if the ranks are balanced
+  mfem::ParMesh * RebalancedMesh(const mfem::real_t imbalance_tol=1.05) const;
+
+  //Action of the Jacobian (at the last
+  //linearisation point) on v
+  void JacobianMult(const Vector & v, Vector & y) const;
 
   //Prepare the operator before solving the
   //problem, does miscallaneous things such as:
@@ -134,23 +465,29 @@ public:
 
   //Returns a handle to the Jacobian
   mfem::Operator & GetGradient(const mfem::Vector &x) const override;
-};
 
-//An inverse iterator
-//to 
-template<typename uint>
-void InvIterator(const uint & Ik, uint & IElm, uint & IDof, uint & Ip){
+  //The energy e(x) of the form (summed over
+  //all the ranks), e.g. for line searches
+  mfem::real_t GetEnergy(const Vector & x) const;
 
+  //The residual (y) and the Jacobian at x
+  //in one element pass, returns the Jacobian
+  mfem::Operator & MultAndGradient(const Vector & x, Vector & y) const;
 };
 
+//Mixed precision form, float evaluation
+//and double accumulation
+using tADNLFormMixed = tADNLForm<REAL32,REAL64>;
+
+
 /*****************************************\
 !
 ! Construct the non-linear form
 !
 \*****************************************/
 //Size the operator
-template<typename Number>
-int tADNLForm<Number>::OperatorSize(const std::vector<ParGridFunction*> & TrueVars_)
+template<typename Number, typename AccumNumber>
+int tADNLForm<Number,AccumNumber>::OperatorSize(const std::vector<ParGridFunction*> & TrueVars_)
 {
   int Size=0;
   for(int I=0; I<TrueVars_.size(); I++) Size += TrueVars_[I]->ParFESpace()->TrueVSize();
@@ -158,42 +495,26 @@ int tADNLForm<Number>::OperatorSize(const std::vector<ParGridFunction*> & TrueVa
 };
 
 //The constructor
-template<typename Number>
-tADNLForm<Number>::tADNLForm(const std::vector<ParGridFunction*> & TrueVars_, const mfem::Device & dev
+template<typename Number, typename AccumNumber>
+tADNLForm<Number,AccumNumber>::tADNLForm(const std::vector<ParGridFunction*> & TrueVars_, const mfem::Device & dev
                            , const mfem::MemoryType & mt_, const bool & use_dev_):
                              mfem::Operator(OperatorSize(TrueVars_),OperatorSize(TrueVars_))
-                           , TrueVars(TrueVars_), device(dev), mt(mt_), use_dev(use_dev_)
+                           , TrueVars(TrueVars_), use_dev(use_dev_), device(dev), mt(mt_)
 {
   //////////////////////////
   ///Recover the problem sizes
   ///from the gridFunctions
   //////////////////////////
-  nElms = TrueVars[0]->ParFESpace()->GetMesh()->GetNE();
-  nEQs  = OperatorSize(TrueVars_);
-  for(int I=0; I<TrueVars.size(); I++){
-    int NDofVar=0;
-    for(int J=0; J<nElms; J++){
-      DofTransformation doftrans;
-      mfem::Array<int> dofs;
-      TrueVars[I]->ParFESpace()->GetElementDofs(J,dofs,doftrans);
-      NDofVar = std::max(dofs.Size(),NDofVar);
-      nElmDofs += dofs.Size();
-    }
-    nDofsMax += NDofVar;
-  }
+  for(unsigned I=0; I<TrueVars.size(); I++) ParFEs.Append(TrueVars[I]->ParFESpace());
 
   //////////////////////////
-  ///Allocate the memory objects
+  ///The restriction and
+  ///interpolation operators
+  ///and the element vectors
   //////////////////////////
-  elMats.SetSize(nDofsMax);
-  EBlockVector   = new mfem::Vector(nElmDofs,mt_);
-  EBlockResidual = new mfem::Vector(nElmDofs,mt_);
-
-  //////////////////////////
-  ///Check sizes
-  //////////////////////////
-  std::cout <<  EBlockVector->Size()   << std::endl;
-  std::cout <<  EBlockResidual->Size() << std::endl;
+  IOp = new tInterpolator();
+  geomFactors = new tGeometricFactors(TrueVars[0]->ParFESpace()->GetMesh(), use_dev, mt_);
+  SizeElements();
 
   //////////////////////////
   ///Clear the Multi-Variate
@@ -203,16 +524,55 @@ tADNLForm<Number>::tADNLForm(const std::vector<ParGridFunction*> & TrueVars_, co
   clearIterator(IO_VarIterator);
 };
 
+//The restriction and element vectors
+//of the current mesh partition
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SizeElements()
+{
+  nElms  = TrueVars[0]->ParFESpace()->GetMesh()->GetNE();
+  nEQs   = OperatorSize(TrueVars);
+  height = width = nEQs;
+
+  delete elem_restrict;
+  elem_restrict = new tRestrictOperator<int>(ParFEs, use_dev);
+  nDofsMax = elem_restrict->GetNDofsMax();
+  nElmDofs = nDofsMax*nElms;
+  scheduler.SetNItems(nElms);
+  elmTimes.assign(nElms, 0.0);
+
+  //////////////////////////
+  ///Allocate the memory objects
+  //////////////////////////
+  elMats.SetSize(nDofsMax);
+  delete EBlockVector;
+  delete EBlockResidual;
+  EBlockVector   = new mfem::Vector(nElmDofs,mt);
+  EBlockResidual = new mfem::Vector(nElmDofs,mt);
+};
+
 /*****************************************\
 !
 ! Destroy the Form
 !
 \*****************************************/
-template<typename Number>
-tADNLForm<Number>::~tADNLForm()
+template<typename Number, typename AccumNumber>
+tADNLForm<Number,AccumNumber>::~tADNLForm()
 {
   clearIterator(IO_VarIterator);
-  delete EBlockVector, EBlockResidual;
+  delete EBlockVector;
+  delete EBlockResidual;
+  delete xE_Samp;
+  delete coeffE_Samp;
+  delete rE_Samp;
+  delete DE_Samp;
+  delete xLin_Samp;
+  delete elMatsE;
+  delete xERef;
+  delete csr_assembler;
+  delete Jacobian_mf;
+  delete elem_restrict;
+  delete IOp;
+  delete geomFactors;
 };
 
 /*****************************************\
@@ -222,11 +582,178 @@ tADNLForm<Number>::~tADNLForm()
 !  in the iterator class
 !
 \*****************************************/
-template<typename Number>
-void tADNLForm<Number>::AddTVar(const Var<int> & newVar, const mfem::Operator & InterpOp)
+template<typename Number, typename AccumNumber>
+unsigned tADNLForm<Number,AccumNumber>::AddIntegRule(const mfem::IntegrationRule & ir)
 {
-  //IOp->AddInterpolator(newVar.ParentTrueVar, InterpOp)
+  IntegRules.push_back(&ir);
+  geomFactors->SetIntegRule(IntegRules.size()-1, ir);
+  return IntegRules.size()-1;
+};
+
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::AddTVar(const Var<int> & newVar, const mfem::DenseMatrix & InterpOp)
+{
+  //The Var is placed after the
+  //previous Vars at each point
+  int TVarSize=1;
+  for(int I=0; I<newVar.TRank; I++) TVarSize *= newVar.sizes[I];
+  IOp->AddInterpolator(IO_VarIterator.Tsize, TVarSize, elem_restrict->GetElmDofOffset(newVar.ParentTrueVar), InterpOp);
   AddVarIteratorDat(IO_VarIterator, newVar.TRank, newVar.sizes);
+  nVars++;
+  VarIterUpdateFlag=true;
+};
+
+/*****************************************\
+!
+!  Adding an energy functional, its
+!  residual kernel evaluates the gradient
+!  of the energy density with regards to
+!  the sampled Vars (one vector-mode dual
+!  evaluation per integration point) for
+!  every element in one batched loop
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+template<typename EnergyT>
+void tADNLForm<Number,AccumNumber>::AddEnergy(const EnergyT & energy)
+{
+  constexpr unsigned nInps = EnergyT::nInputs;
+  const unsigned ID = energy.GetIntegRule();
+  MFEM_VERIFY(ID < IntegRules.size(), "tADNLForm: unknown integration rule");
+  MFEM_VERIFY((Rfuncs.size() == 0) or (ID == SampIntegRuleID), "tADNLForm: the energies must share an integration rule");
+  SampIntegRuleID = ID;
+
+  Rfuncs.push_back([this, energy](const tVectorMFEM<Number> & xS, const tVectorMFEM<Number> & cS, tVectorMFEM<AccumNumber> & rS
+                                , const mfem::Array<int> *elems)
+  {
+    MFEM_VERIFY(int(nInps) == VarSize, "tADNLForm: the energy inputs are not the sampled Vars");
+    const int nC = nCoeffs;
+    const auto d_x = xS.Read(use_dev);
+    const auto d_c = cS.Read(use_dev);
+    auto d_r = rS.ReadWrite(use_dev);
+    if(reverse_mode){
+      //Reverse mode, the tape of the
+      //calling thread (host only)
+      MFEM_VERIFY(not use_dev, "tADNLForm: the reverse mode is host only");
+      PointForall(elems, [=](int Iq)
+      {
+        const Number *vars = d_x + Iq*nInps, *coeffs = d_c + Iq*nC;
+        Number dedx[nInps];
+        tAdjointGradient<Number>([&](const auto xTape[]){return energy.Eval(xTape, coeffs);}, vars, dedx, nInps);
+        for(unsigned I=0; I<nInps; I++) d_r[Iq*nInps + I] += AccumNumber(coeffs[0])*AccumNumber(dedx[I]);
+      });
+      return;
+    }
+    PointForall(elems, [=] MFEM_HOST_DEVICE (int Iq)
+    {
+      const Number *vars = d_x + Iq*nInps, *coeffs = d_c + Iq*nC;
+      Number dedx[nInps];
+      tGradient<nInps>([&](const auto xDual[]){return energy.Eval(xDual, coeffs);}, vars, dedx);
+      for(unsigned I=0; I<nInps; I++) d_r[Iq*nInps + I] += AccumNumber(coeffs[0])*AccumNumber(dedx[I]);
+    });
+  });
+
+  //The Hessian kernel (second
+  //order dual numbers)
+  Jfuncs.push_back([this, energy](const tVectorMFEM<Number> & xS, const tVectorMFEM<Number> & cS, tVectorMFEM<Number> & DS
+                                , const mfem::Array<int> *elems)
+  {
+    const int nC = nCoeffs;
+    const auto d_x = xS.Read(use_dev);
+    const auto d_c = cS.Read(use_dev);
+    auto d_D = DS.ReadWrite(use_dev);
+    PointForall(elems, [=] MFEM_HOST_DEVICE (int Iq)
+    {
+      const Number *vars = d_x + Iq*nInps, *coeffs = d_c + Iq*nC;
+      Number dedx[nInps], d2edx2[nInps*nInps];
+      tHessian<nInps>([&](const auto xHess[]){return energy.Eval(xHess, coeffs);}, vars, dedx, d2edx2);
+      for(unsigned I=0; I<nInps*nInps; I++) d_D[Iq*nInps*nInps + I] += coeffs[0]*d2edx2[I];
+    });
+  });
+
+  //The energy kernel (no dual lanes)
+  Efuncs.push_back([this, energy](const tVectorMFEM<Number> & xS, const tVectorMFEM<Number> & cS, tVectorMFEM<AccumNumber> & eS)
+  {
+    const int nC = nCoeffs;
+    const auto d_x = xS.Read(use_dev);
+    const auto d_c = cS.Read(use_dev);
+    auto d_e = eS.ReadWrite(use_dev);
+    PointForall(NULL, [=] MFEM_HOST_DEVICE (int Ik)
+    {
+      const Number *coeffs = d_c + Ik*nC;
+      d_e[Ik] += AccumNumber(coeffs[0])*AccumNumber(energy.Eval(d_x + Ik*nInps, coeffs));
+    });
+  });
+
+  //The fused kernel, the gradient and
+  //Hessian of one second order evaluation
+  RJfuncs.push_back([this, energy](const tVectorMFEM<Number> & xS, const tVectorMFEM<Number> & cS
+                                 , tVectorMFEM<AccumNumber> & rS, tVectorMFEM<Number> & DS, const mfem::Array<int> *elems)
+  {
+    const int nC = nCoeffs;
+    const auto d_x = xS.Read(use_dev);
+    const auto d_c = cS.Read(use_dev);
+    auto d_r = rS.ReadWrite(use_dev);
+    auto d_D = DS.ReadWrite(use_dev);
+    PointForall(elems, [=] MFEM_HOST_DEVICE (int Iq)
+    {
+      const Number *vars = d_x + Iq*nInps, *coeffs = d_c + Iq*nC;
+      Number dedx[nInps], d2edx2[nInps*nInps];
+      tHessian<nInps>([&](const auto xHess[]){return energy.Eval(xHess, coeffs);}, vars, dedx, d2edx2);
+      for(unsigned I=0; I<nInps; I++) d_r[Iq*nInps + I] += AccumNumber(coeffs[0])*AccumNumber(dedx[I]);
+      for(unsigned I=0; I<nInps*nInps; I++) d_D[Iq*nInps*nInps + I] += coeffs[0]*d2edx2[I];
+    });
+  });
+
+  //The directional derivative kernel, the
+  //gradient with dual Vars x + eps.v
+  JVfuncs.push_back([this, energy](const tVectorMFEM<Number> & xS, const tVectorMFEM<Number> & vS
+                                 , const tVectorMFEM<Number> & cS, tVectorMFEM<AccumNumber> & JvS)
+  {
+    const int nC = nCoeffs;
+    const auto d_x = xS.Read(use_dev);
+    const auto d_v = vS.Read(use_dev);
+    const auto d_c = cS.Read(use_dev);
+    auto d_Jv = JvS.ReadWrite(use_dev);
+    PointForall(NULL, [=] MFEM_HOST_DEVICE (int Ik)
+    {
+      const Number *coeffs = d_c + Ik*nC;
+      dualSymNum<Number> vars[nInps], dedx[nInps];
+      for(unsigned I=0; I<nInps; I++) vars[I] = dualSymNum<Number>(d_x[Ik*nInps + I], d_v[Ik*nInps + I]);
+      tGradient<nInps>([&](const auto xDual[]){return energy.Eval(xDual, coeffs);}, vars, dedx);
+      for(unsigned I=0; I<nInps; I++) d_Jv[Ik*nInps + I] += AccumNumber(coeffs[0])*AccumNumber(dedx[I].grad);
+    });
+  });
+};
+
+/*****************************************\
+!
+!  Set the assembly level of the Jacobian
+!  (re-prepares the operator)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SetAssemblyLevel(const mfem::AssemblyLevel level)
+{
+  MFEM_VERIFY(level != mfem::AssemblyLevel::LEGACY, "tADNLForm: unsupported assembly level");
+  assembly_level = level;
+  autotune_nKrylov=0;
+  VarIterUpdateFlag=true;
+};
+
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SetAutoTune(const int nKrylovIts)
+{
+  MFEM_VERIFY(nKrylovIts > 0, "tADNLForm: the autotuner needs the expected Krylov iterations");
+  autotune_nKrylov = nKrylovIts;
+  autotune_sequence=-1;
+  VarIterUpdateFlag=true;
+};
+
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SetIncrementalJacobian(const mfem::real_t tol)
+{
+  incr_tol = tol;
   VarIterUpdateFlag=true;
 };
 
@@ -236,35 +763,181 @@ void tADNLForm<Number>::AddTVar(const Var<int> & newVar, const mfem::Operator &
 !  and GetGradient functions
 !
 \*****************************************/
-template<typename Number>
-void tADNLForm<Number>::PrepareOperator() const
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::PrepareOperator() const
 {
   //Update the MFEM Var iterator
   MakeMultiVarMFEMIter<int>(mt, IO_VarIterator, MFEM_VarIterator);
 
-  //Rebuild the Interpolator (TODO)
+  //Rebuild the Interpolator
+  VarSize = IO_VarIterator.Tsize;
+  IOp->Assemble(VarSize, nDofsMax);
+  nQuads = IOp->GetNQuads();
+  sum_nIps_nVars = nQuads*VarSize;
+  MFEM_VERIFY(IntegRules.empty() or (nQuads == IntegRules[SampIntegRuleID]->GetNPoints())
+            , "tADNLForm: the Vars are not sampled at the integration points");
 
+  //The geometric coefficients [w.detJ, invJ]
+  const mfem::Mesh *mesh = TrueVars[0]->ParFESpace()->GetMesh();
+  nCoeffs = 1 + mesh->Dimension()*mesh->SpaceDimension();
 
-  //Update the vector size for the sampled variables  
-  int VarSize = IO_VarIterator.Tsize;
+  //Update the vector size for the sampled variables
+  //(stored in the evaluation precision)
   if(xE_Samp != NULL){ delete xE_Samp;  xE_Samp=NULL;};
-  if((xE_Samp == NULL)and(VarSize !=0)) xE_Samp= new mfem::Vector(VarSize*nElms,mt);
+  if((xE_Samp == NULL)and(VarSize !=0)) xE_Samp= new tVectorMFEM<Number>(sum_nIps_nVars*nElms,mt);
 
   if(coeffE_Samp != NULL){ delete coeffE_Samp; coeffE_Samp=NULL;};
-  if((xE_Samp == NULL)and(VarSize !=0)) coeffE_Samp = new mfem::Vector(VarSize*nElms,mt);
+  if((coeffE_Samp == NULL)and(VarSize !=0)) coeffE_Samp = new tVectorMFEM<Number>(nCoeffs*nQuads*nElms,mt);
+  coeffs_valid=false;
+
+  //Build the geometric factors (cached
+  //until the mesh changes)
+  if((VarSize != 0) and (not IntegRules.empty())) SampleCoeffs();
+
+  if(rE_Samp != NULL){ delete rE_Samp; rE_Samp=NULL;};
+  if((rE_Samp == NULL)and(VarSize !=0)) rE_Samp = new tVectorMFEM<AccumNumber>(sum_nIps_nVars*nElms,mt);
 
   //Set the flag to false
   VarIterUpdateFlag=false;
+
+  //The Jacobian storage (of the fastest
+  //assembly level, tuned once per mesh)
+  if((autotune_nKrylov > 0) and (autotune_sequence != mesh->GetSequence())){
+    AutoTune();
+    autotune_sequence = mesh->GetSequence();
+  }else{
+    AllocateJacobian();
+  }
 }
 
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::AllocateJacobian(const bool keep_pattern) const
+{
+  const bool full = (assembly_level == mfem::AssemblyLevel::FULL);
+  const bool none = (assembly_level == mfem::AssemblyLevel::NONE);
+  if(DE_Samp != NULL){ delete DE_Samp; DE_Samp=NULL;};
+  if((not none) and (VarSize !=0)) DE_Samp = new tVectorMFEM<Number>(sum_nIps_nVars*VarSize*nElms,mt);
+
+  if(xLin_Samp != NULL){ delete xLin_Samp; xLin_Samp=NULL;};
+  if(none and (VarSize !=0)) xLin_Samp = new tVectorMFEM<Number>(sum_nIps_nVars*nElms,mt);
+
+  //(FULL keeps the element matrices of the
+  //last linearisation when incremental)
+  const bool incr = (incr_tol >= 0.0) and (not none);
+  if(elMatsE != NULL){ delete elMatsE; elMatsE=NULL;};
+  if((assembly_level == mfem::AssemblyLevel::ELEMENT) or (full and incr)) elMatsE = new mfem::Vector(nDofsMax*nDofsMax*nElms,mt);
+
+  if(xERef != NULL){ delete xERef; xERef=NULL;};
+  if(incr) xERef = new mfem::Vector(nElmDofs,mt);
+  incr_valid=false;
+
+  //The Jacobian sparsity pattern and
+  //scatter maps (only depend on the
+  //FE-spaces, built once)
+  if(full and (csr_assembler == NULL)) csr_assembler = new tParCSRAssembler<int>(ParFEs, *elem_restrict);
+  if((not full) and (not keep_pattern) and (csr_assembler != NULL)){ delete csr_assembler; csr_assembler=NULL;};
+  if((not full) and (Jacobian_mf == NULL)) Jacobian_mf = new tMFJacobian<tADNLForm>(*this);
+  Jacobian_f = NULL;
+};
+
+/*****************************************\
+!
+!  Autotune the assembly level, each level
+!  is timed at the current TrueVars (the
+!  slowest rank counts):
+!   tBuild : Jacobian build (after a warm
+!            up, i.e. the FULL pattern is
+!            excluded, it is built once and
+!            kept while the other levels
+!            are timed)
+!   tApply : Jacobian action
+!  and the level with the least
+!   tBuild + nKrylov.tApply
+!  is kept, the table is logged
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::AutoTune() const
+{
+  const mfem::AssemblyLevel levels[4] = {mfem::AssemblyLevel::FULL, mfem::AssemblyLevel::ELEMENT
+                                       , mfem::AssemblyLevel::PARTIAL, mfem::AssemblyLevel::NONE};
+  const char *names[4] = {"FULL", "ELEMENT", "PARTIAL", "NONE"};
+  const int nApply=5;
+  MPI_Comm comm = ParFEs[0]->GetComm();
+  const int myid = ParFEs[0]->GetMyRank();
+
+  //The current state of the TrueVars
+  mfem::Vector x(Height()), v(Height()), Jv(Height());
+  for(int I=0, off=0; I<int(TrueVars.size()); I++){
+    mfem::Vector xI(x, off, TrueVars[I]->ParFESpace()->GetTrueVSize());
+    TrueVars[I]->GetTrueDofs(xI);
+    off += TrueVars[I]->ParFESpace()->GetTrueVSize();
+  }
+  v = 1.0;
+
+  //Time complete builds
+  const mfem::real_t tol = incr_tol;
+  incr_tol = -1.0;
+
+  double cost[4], times[8], storage[4];
+  for(int ILvl=0; ILvl<4; ILvl++){
+    assembly_level = levels[ILvl];
+    AllocateJacobian(true);
+    buildJacobian(x);
+
+    mfem::StopWatch tBuild, tApply;
+    tBuild.Start();
+    buildJacobian(x);
+    tBuild.Stop();
+    tApply.Start();
+    for(int I=0; I<nApply; I++) Jacobian_f->Mult(v,Jv);
+    tApply.Stop();
+    times[2*ILvl]     = tBuild.RealTime();
+    times[2*ILvl + 1] = tApply.RealTime()/nApply;
+
+    //Jacobian storage (MB)
+    const double nSampled = double(sum_nIps_nVars)*nElms;
+    switch(levels[ILvl]){
+      case mfem::AssemblyLevel::FULL:    storage[ILvl] = 2.0*csr_assembler->GetLocalNNZ()*sizeof(mfem::real_t); break;
+      case mfem::AssemblyLevel::ELEMENT: storage[ILvl] = double(nDofsMax)*nDofsMax*nElms*sizeof(mfem::real_t); break;
+      case mfem::AssemblyLevel::PARTIAL: storage[ILvl] = nSampled*VarSize*sizeof(Number); break;
+      default:                           storage[ILvl] = nSampled*sizeof(Number); break;
+    }
+    storage[ILvl] /= 1024.0*1024.0;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, times, 8, MPI_DOUBLE, MPI_MAX, comm);
+  MPI_Allreduce(MPI_IN_PLACE, storage, 4, MPI_DOUBLE, MPI_MAX, comm);
+
+  //Keep the cheapest level
+  //(the same on every rank)
+  int IBest=0;
+  for(int ILvl=0; ILvl<4; ILvl++){
+    cost[ILvl] = times[2*ILvl] + autotune_nKrylov*times[2*ILvl + 1];
+    if(cost[ILvl] < cost[IBest]) IBest = ILvl;
+  }
+  if(myid == 0){
+    std::cout << "tADNLForm autotune (" << autotune_nKrylov << " Krylov iterations per Newton step)" << std::endl;
+    std::cout << "  level     build [ms]   apply [ms]   Newton step [ms]   storage [MB]" << std::endl;
+    for(int ILvl=0; ILvl<4; ILvl++){
+      std::printf("  %-8s %11.3f %12.4f %18.3f %14.2f\n", names[ILvl], 1e3*times[2*ILvl]
+                , 1e3*times[2*ILvl + 1], 1e3*cost[ILvl], storage[ILvl]);
+    }
+    std::cout << "  selected " << names[IBest] << ": the cheapest build + " << autotune_nKrylov
+              << " actions per Newton step" << std::endl;
+  }
+  assembly_level = levels[IBest];
+  incr_tol = tol;
+  AllocateJacobian();
+};
+
 /*****************************************\
 !
 !  (Build? and) return the Jacobian
 !             operator
 !
 \*****************************************/
-template<typename Number>
-mfem::Operator & tADNLForm<Number>::GetGradient(const mfem::Vector &x) const
+template<typename Number, typename AccumNumber>
+mfem::Operator & tADNLForm<Number,AccumNumber>::GetGradient(const mfem::Vector &x) const
 {
   buildJacobian(x);
   return *Jacobian_f;
@@ -277,52 +950,641 @@ mfem::Operator & tADNLForm<Number>::GetGradient(const mfem::Vector &x) const
 !             and output
 !
 \*****************************************/
-template<typename Number>
-void tADNLForm<Number>::Mult(const Vector & x, Vector & y) const
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::Mult(const Vector & x, Vector & y) const
 {
   //Rebuild the MultiVarIterator,
   //Interpolator and sampler, if
   //the user has forgotten
   if(VarIterUpdateFlag) PrepareOperator();
 
+  //Evaluate the residual of the
+  //energies at the sample points
+  auto evalResidual = [&](const mfem::Array<int> *elems)
+  {
+    ZeroSampled(*rE_Samp, sum_nIps_nVars, elems);
+    for(unsigned ICoeff=0; ICoeff<Rfuncs.size(); ICoeff++) Rfuncs[ICoeff](*xE_Samp, *coeffE_Samp, *rE_Samp, elems);
+  };
+
+  //Get the residual vector and apply the essential BC's
+  ResidualPass(x, y, evalResidual);
+  if(ess_bcs_tdofs.Size() != 0)    y.SetSubVector(ess_bcs_tdofs,0.00);
+};
+
+/*****************************************\
+!
+!  Matrix-free action of the Jacobian
+!  J.v, a directional derivative of the
+!  residual at the linearisation point
+!  (the constrained rows/columns are
+!  the identity)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::JacobianMult(const Vector & v, Vector & y) const
+{
+  //Constrained directions
+  const mfem::Vector *vC = &v;
+  if(ess_bcs_tdofs.Size() != 0){
+    vConstrained = v;
+    vConstrained.SetSubVector(ess_bcs_tdofs,0.00);
+    vC = &vConstrained;
+  }
+
+  //Restrict the direction
+  elem_restrict->Mult(*vC,*EBlockVector);
+
+  //The stored element matrices,
+  //a batched GEMV K_e.v_e
+  if(assembly_level == mfem::AssemblyLevel::ELEMENT){
+    tElementMultE<AccumNumber>(use_dev, nElms, nDofsMax, elMatsE->Read(use_dev)
+                             , EBlockVector->Read(use_dev), EBlockResidual->Write(use_dev));
+    elem_restrict->MultTranspose(*EBlockResidual,y);
+    if(ess_bcs_tdofs.Size() != 0){
+      mfem::Vector vEss;
+      v.GetSubVector(ess_bcs_tdofs, vEss);
+      y.SetSubVector(ess_bcs_tdofs, vEss);
+    }
+    return;
+  }
+
+  //Sample the direction (xE_Samp
+  //is free between residuals)
+  const mfem::DenseMatrix & B = IOp->GetMat();
+  tInterpolateE<Number,AccumNumber>(use_dev, nElms, sum_nIps_nVars, nDofsMax, B.Read(use_dev)
+                                  , EBlockVector->Read(use_dev), xE_Samp->Write(use_dev));
+
+  if(assembly_level == mfem::AssemblyLevel::PARTIAL){
+    //The stored Hessians D.(Q.R.v)
+    const int VS = VarSize;
+    const auto d_D = DE_Samp->Read(use_dev);
+    const auto d_v = xE_Samp->Read(use_dev);
+    auto d_rSamp = rE_Samp->Write(use_dev);
+    tForall(use_dev, nElms*nQuads, [=] MFEM_HOST_DEVICE (int Ik)
+    {
+      const Number *D = d_D + Ik*VS*VS, *vS = d_v + Ik*VS;
+      for(int I=0; I<VS; I++){
+        AccumNumber sum=0.0;
+        for(int J=0; J<VS; J++) sum += AccumNumber(D[I*VS + J])*AccumNumber(vS[J]);
+        d_rSamp[Ik*VS + I] = sum;
+      }
+    });
+  }else{
+    //Directional derivatives of the
+    //residual at the sample points
+    auto d_rSamp = rE_Samp->Write(use_dev);
+    tForall(use_dev, sum_nIps_nVars*nElms, [=] MFEM_HOST_DEVICE (int Ik){d_rSamp[Ik] = AccumNumber(0.0);});
+    for(unsigned ICoeff=0; ICoeff<JVfuncs.size(); ICoeff++) JVfuncs[ICoeff](*xLin_Samp, *xE_Samp, *coeffE_Samp, *rE_Samp);
+  }
+
+  //Scatter and apply the essential BC's
+  ScatterSampled(y);
+  if(ess_bcs_tdofs.Size() != 0){
+    mfem::Vector vEss;
+    v.GetSubVector(ess_bcs_tdofs, vEss);
+    y.SetSubVector(ess_bcs_tdofs, vEss);
+  }
+};
+
+/*****************************************\
+!
+!  Restrict and interpolate the true DOF's
+!  to the sampled Vars
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SampleVars(const Vector & x) const
+{
   //Get the element data vectors
   //with a restrict operator
-  if(elem_restrict != NULL) elem_restrict->Mult(x,*EBlockVector);
+  elem_restrict->Mult(x,*EBlockVector);
+
+  //Interpolate the DOF's to get
+  //the TrueVars at the sample points
+  const mfem::DenseMatrix & B = IOp->GetMat();
+  tInterpolateE<Number,AccumNumber>(use_dev, nElms, sum_nIps_nVars, nDofsMax, B.Read(use_dev)
+                                  , EBlockVector->Read(use_dev), xE_Samp->Write(use_dev));
+  SampleCoeffs();
+};
+
+//Sum the sampled residuals into the
+//element residuals and the true DOF's
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::ScatterSampled(Vector & y) const
+{
+  const mfem::DenseMatrix & B = IOp->GetMat();
+  tInterpolateTransposeE<AccumNumber,AccumNumber>(use_dev, nElms, sum_nIps_nVars, nDofsMax, B.Read(use_dev)
+                                           , rE_Samp->Read(use_dev), EBlockResidual->Write(use_dev));
+  elem_restrict->MultTranspose(*EBlockResidual,y);
+};
+
+//Restrict and interpolate an element set
+//(the other elements are left as they are)
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SampleElements(const int ISet) const
+{
+  const mfem::Array<int> & elems = elem_restrict->GetElementSet(ISet);
+  elem_restrict->MultElements(ISet,*EBlockVector);
+  const mfem::DenseMatrix & B = IOp->GetMat();
+  tInterpolateE<Number,AccumNumber>(use_dev, elems.Size(), sum_nIps_nVars, nDofsMax, B.Read(use_dev)
+                                  , EBlockVector->Read(use_dev), xE_Samp->ReadWrite(use_dev), elems.Read(use_dev));
+};
 
-  //Some stuff for devices
-  const auto ElmVecs = Reshape(EBlockVector->Read(), nDofsMax, nElms);
-  auto ElmRes = Reshape(EBlockResidual->ReadWrite(), nDofsMax, nElms);
+//Sum the sampled residuals of an element
+//set into the pending reduction
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::ScatterElements(const int ISet) const
+{
+  const mfem::Array<int> & elems = elem_restrict->GetElementSet(ISet);
+  const mfem::DenseMatrix & B = IOp->GetMat();
+  tInterpolateTransposeE<AccumNumber,AccumNumber>(use_dev, elems.Size(), sum_nIps_nVars, nDofsMax, B.Read(use_dev)
+                                           , rE_Samp->Read(use_dev), EBlockResidual->ReadWrite(use_dev), elems.Read(use_dev));
+  elem_restrict->MultTransposeElements(ISet,*EBlockResidual);
+};
 
-  //Partially assemble the sampled
-  //variables used for calculating
-  //the residuals
-  mfem::forall_switch(use_dev, nElms*sum_nIps_nVars, [=] MFEM_HOST_DEVICE (int Ik)
+/*****************************************\
+!
+!  Residual pass with the halo exchanges
+!  overlapped (host, conforming spaces):
+!   -post the broadcast of the owned DOF's
+!    and evaluate the interior elements
+!    (half A) while it is in flight
+!   -finish it, evaluate the interface
+!    elements and post their reduction
+!   -evaluate and sum the interior elements
+!    (half B, then A) while the reduction
+!    is in flight
+!  otherwise the blocking restrict ->
+!  evaluate -> scatter
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+template<typename EVAL>
+void tADNLForm<Number,AccumNumber>::ResidualPass(const Vector & x, Vector & y, EVAL && eval) const
+{
+  typedef tRestrictOperator<int> tR;
+  if(not elem_restrict->Overlaps()){
+    SampleVars(x);
+    eval(NULL);
+    ScatterSampled(y);
+    return;
+  }
+
+  //The interior elements only
+  //need the owned DOF's
+  SampleCoeffs();
+  elem_restrict->MultBegin(x);
+  SampleElements(tR::INTERIOR_A);
+  SampleElements(tR::INTERIOR_B);
+  eval(&elem_restrict->GetElementSet(tR::INTERIOR_A));
+  elem_restrict->MultEnd();
+
+  //The interface elements, their
+  //sums go first
+  SampleElements(tR::INTERFACE);
+  eval(&elem_restrict->GetElementSet(tR::INTERFACE));
+  elem_restrict->MultTransposeInit();
+  ScatterElements(tR::INTERFACE);
+  elem_restrict->MultTransposeBegin();
+
+  //The rest of the interior
+  eval(&elem_restrict->GetElementSet(tR::INTERIOR_B));
+  ScatterElements(tR::INTERIOR_A);
+  ScatterElements(tR::INTERIOR_B);
+  elem_restrict->MultTransposeEnd(y);
+};
+
+/*****************************************\
+!
+!  Sample the geometric coefficients of
+!  each element at the integration points
+!  [w.detJ, invJ (dim x sdim)], packed from
+!  the cached factors of the sampling rule
+!  (SoA) only when they were rebuilt
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::SampleCoeffs() const
+{
+  const bool rebuilt = geomFactors->Update(SampIntegRuleID);
+  if(coeffs_valid and (not rebuilt)) return;
+
+  const int nC = nCoeffs, nQE = nQuads*nElms;
+  const auto W    = geomFactors->GetW(SampIntegRuleID).Read(use_dev);
+  const auto invJ = geomFactors->GetInvJ(SampIntegRuleID).Read(use_dev);
+  auto d_c = coeffE_Samp->Write(use_dev);
+  tForall(use_dev, nQE, [=] MFEM_HOST_DEVICE (int Iq)
   {
-    //The recover the sub iterators
-    unsigned IElm, IDof, Ip;
-    InvIterator<unsigned>(Ik, IElm, IDof, Ip);
-
-    //Interpolate the DOF's to get
-    //the TrueVars at the sample points
-    for(unsigned JDof=0; JDof<nDofsMax; JDof++){
-//    g_Xp(Ik) = IOp.GetMat()(Ik,JDof)*(ElmVecs(IElm,JDof) + ((JDof==0)?zero:g_Xp(Ik));
-    }
-//
-  //for(unsigned ICoeff=0; ICoeff<Rfuncs.size(); ICoeff++){
-  //    Rfuncs(xtmp, MFEM_VarIterator, IElm, Ip);
-//  std::vector<std::function<void(const Vector & x, const MFEMVarIterData<int> & Iter)>> Rfuncs; 
-// Rfuncs; 
+    d_c[Iq*nC] = Number(W[Iq]);
+    for(int K=1; K<nC; K++) d_c[Iq*nC + K] = Number(invJ[(K-1)*nQE + Iq]);
   });
+  coeffs_valid=true;
+};
 
-  //Get the residual vector and apply the essential BC's
-  if(elem_restrict        != NULL) elem_restrict->MultTranspose(*EBlockResidual,y);
+/*****************************************\
+!
+!     Assemble the Jacobian matrix
+!  (only the values are overwritten)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::buildJacobian(const Vector & x) const
+{
+  const bool full = (assembly_level == mfem::AssemblyLevel::FULL);
+  if(VarIterUpdateFlag or (full and (csr_assembler == NULL)) or ((not full) and (Jacobian_mf == NULL))) PrepareOperator();
+
+  //Sample the Vars at the linearisation
+  //point and evaluate the Hessians (of
+  //the elements that moved)
+  SampleVars(x);
+  const mfem::Array<int> *elems = SelectActiveElements();
+  if(assembly_level != mfem::AssemblyLevel::NONE) EvaluateHessians(elems);
+  FinishJacobian(elems);
+};
+
+/*****************************************\
+!
+!  The energy of the form, one element
+!  pass with plain Number arithmetic (the
+!  point energies w.detJ.e are summed in
+!  AccumNumber) and a single reduction
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+mfem::real_t tADNLForm<Number,AccumNumber>::GetEnergy(const Vector & x) const
+{
+  if(VarIterUpdateFlag) PrepareOperator();
+
+  //Point energies (rE_Samp
+  //is free between residuals)
+  SampleVars(x);
+  auto d_eSamp = rE_Samp->Write(use_dev);
+  tForall(use_dev, nQuads*nElms, [=] MFEM_HOST_DEVICE (int Ik){d_eSamp[Ik] = AccumNumber(0.0);});
+  for(unsigned ICoeff=0; ICoeff<Efuncs.size(); ICoeff++) Efuncs[ICoeff](*xE_Samp, *coeffE_Samp, *rE_Samp);
+
+  //Sum the rank and reduce
+  const AccumNumber *h_eSamp = rE_Samp->Read(false);
+  AccumNumber eLoc(0.0);
+  for(int Ik=0; Ik<nQuads*nElms; Ik++) eLoc += h_eSamp[Ik];
+  double e = double(eLoc);
+  MPI_Allreduce(MPI_IN_PLACE, &e, 1, MPI_DOUBLE, MPI_SUM, ParFEs[0]->GetComm());
+  return mfem::real_t(e);
+};
+
+/*****************************************\
+!
+!  The residual and the Jacobian at the
+!  same state in one element pass, the
+!  second order duals give the gradient
+!  (residual) and the Hessian together
+!  (one restriction, interpolation and
+!  energy evaluation)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+mfem::Operator & tADNLForm<Number,AccumNumber>::MultAndGradient(const Vector & x, Vector & y) const
+{
+  const bool full = (assembly_level == mfem::AssemblyLevel::FULL);
+  if(VarIterUpdateFlag or (full and (csr_assembler == NULL)) or ((not full) and (Jacobian_mf == NULL))) PrepareOperator();
+
+  //Fused residual and Hessians of the
+  //listed elements (matrix-free, only
+  //the residual)
+  auto evalFused = [&](const mfem::Array<int> *elems)
+  {
+    ZeroSampled(*rE_Samp, sum_nIps_nVars, elems);
+    if(assembly_level == mfem::AssemblyLevel::NONE){
+      for(unsigned ICoeff=0; ICoeff<Rfuncs.size(); ICoeff++) Rfuncs[ICoeff](*xE_Samp, *coeffE_Samp, *rE_Samp, elems);
+    }else{
+      ZeroSampled(*DE_Samp, sum_nIps_nVars*VarSize, elems);
+      for(unsigned ICoeff=0; ICoeff<RJfuncs.size(); ICoeff++) RJfuncs[ICoeff](*xE_Samp, *coeffE_Samp, *rE_Samp, *DE_Samp, elems);
+    }
+  };
+
+  //The residual, the incremental Jacobian
+  //selects the moved elements on every
+  //element vector (no overlap), the others
+  //only get their residual
+  const mfem::Array<int> *elems = NULL;
+  if((incr_tol >= 0.0) and (assembly_level != mfem::AssemblyLevel::NONE)){
+    SampleVars(x);
+    elems = SelectActiveElements();
+    if(elems != NULL){
+      ZeroSampled(*rE_Samp, sum_nIps_nVars, &inactiveElms);
+      for(unsigned ICoeff=0; ICoeff<Rfuncs.size(); ICoeff++) Rfuncs[ICoeff](*xE_Samp, *coeffE_Samp, *rE_Samp, &inactiveElms);
+    }
+    evalFused(elems);
+    ScatterSampled(y);
+  }else{
+    ResidualPass(x, y, evalFused);
+  }
   if(ess_bcs_tdofs.Size() != 0)    y.SetSubVector(ess_bcs_tdofs,0.00);
+
+  //The Jacobian
+  FinishJacobian(elems);
+  return *Jacobian_f;
 };
 
 /*****************************************\
 !
-!     Assemble the Jacobian matrix
+!  Build the Jacobian of the assembly level
+!  from the sampled Vars/Hessians
 !
 \*****************************************/
-template<typename Number>
-void tADNLForm<Number>::buildJacobian(const Vector & x) const {};
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::FinishJacobian(const mfem::Array<int> *elems) const
+{
+  switch(assembly_level){
+    case mfem::AssemblyLevel::NONE:
+      //Keep the sampled Vars
+      std::swap(xE_Samp, xLin_Samp);
+      Jacobian_f = Jacobian_mf;
+      break;
+    case mfem::AssemblyLevel::PARTIAL:
+      //Keep the Hessians
+      Jacobian_f = Jacobian_mf;
+      break;
+    case mfem::AssemblyLevel::ELEMENT:
+      //Keep the element matrices
+      tElementMatricesE<Number,AccumNumber>(use_dev, (elems == NULL)? nElms: elems->Size(), nQuads, VarSize, nDofsMax
+                                          , IOp->GetMat().Read(use_dev), DE_Samp->Read(use_dev), elMatsE->ReadWrite(use_dev)
+                                          , (elems == NULL)? NULL: elems->Read(use_dev));
+      Jacobian_f = Jacobian_mf;
+      break;
+    default:
+      AssembleFull(elems);
+      break;
+  }
+};
+
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::EvaluateHessians(const mfem::Array<int> *elems) const
+{
+  ZeroSampled(*DE_Samp, sum_nIps_nVars*VarSize, elems);
+  for(unsigned ICoeff=0; ICoeff<Jfuncs.size(); ICoeff++) Jfuncs[ICoeff](*xE_Samp, *coeffE_Samp, *DE_Samp, elems);
+};
+
+template<typename Number, typename AccumNumber>
+template<typename BODY>
+void tADNLForm<Number,AccumNumber>::PointForall(const mfem::Array<int> *elems, BODY && body) const
+{
+  const int nQ = nQuads;
+  const int nE = (elems == NULL)? nElms: elems->Size();
+  const bool timing = elm_timing and (not use_dev);
+  if(use_dev or ((tHostThreads::GetNumThreads() <= 1) and (not timing))){
+    const int *d_el = (elems == NULL)? NULL: elems->Read(use_dev);
+    tForall(use_dev, nE*nQ, [=] MFEM_HOST_DEVICE (int Ik)
+    {
+      body((d_el == NULL)? Ik: d_el[Ik/nQ]*nQ + Ik%nQ);
+    });
+  }else{
+    //Work-stealing over the elements
+    //(the element costs differ), each
+    //element is on one thread
+    double *h_t = elmTimes.data();
+    scheduler.Forall(nE, (elems == NULL)? NULL: elems->HostRead(), [&](const int IElm)
+    {
+      const double t0 = (timing)? tHostThreads::ThreadTime(): 0.0;
+      for(int Ip=0; Ip<nQ; Ip++) body(IElm*nQ + Ip);
+      if(timing) h_t[IElm] += tHostThreads::ThreadTime() - t0;
+    });
+  }
+};
+
+template<typename Number, typename AccumNumber>
+template<typename T>
+void tADNLForm<Number,AccumNumber>::ZeroSampled(tVectorMFEM<T> & v, const int stride, const mfem::Array<int> *elems) const
+{
+  const int nE = (elems == NULL)? nElms: elems->Size();
+  const int *d_el = (elems == NULL)? NULL: elems->Read(use_dev);
+  auto d_v = (elems == NULL)? v.Write(use_dev): v.ReadWrite(use_dev);
+  tForall(use_dev, nE*stride, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int IElm = (d_el == NULL)? Ik/stride: d_el[Ik/stride];
+    d_v[IElm*stride + Ik%stride] = T(0.0);
+  });
+};
+
+/*****************************************\
+!
+!  Select the elements to relinearise, an
+!  element is relinearised when one of its
+!  DOF's moved more than incr_tol since
+!  its last linearisation (every element
+!  on the first pass), the others keep
+!  their Hessians/element matrices
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+const mfem::Array<int> * tADNLForm<Number,AccumNumber>::SelectActiveElements() const
+{
+  if((incr_tol < 0.0) or (assembly_level == mfem::AssemblyLevel::NONE)) return NULL;
+  const int nD = nDofsMax;
+  const mfem::real_t *h_xE = EBlockVector->HostRead();
+  mfem::real_t *h_xRef = xERef->HostReadWrite();
+  incr_rebuild = not incr_valid;
+  activeElms.SetSize(0);
+  inactiveElms.SetSize(0);
+  for(int IElm=0; IElm<nElms; IElm++){
+    mfem::real_t dx=0.0;
+    for(int IDof=0; IDof<nD; IDof++) dx = std::max(dx, std::abs(h_xE[IElm*nD + IDof] - h_xRef[IElm*nD + IDof]));
+    if(incr_rebuild or (dx > incr_tol)){
+      activeElms.Append(IElm);
+      for(int IDof=0; IDof<nD; IDof++) h_xRef[IElm*nD + IDof] = h_xE[IElm*nD + IDof];
+    }else{
+      inactiveElms.Append(IElm);
+    }
+  }
+  incr_valid=true;
+  return &activeElms;
+};
+
+template<typename Number, typename AccumNumber>
+void tADNLForm<Number,AccumNumber>::AssembleFull(const mfem::Array<int> *elems) const
+{
+  //Element matrices Q^T.D.Q (summed over
+  //the points in AccumNumber) scattered
+  //into the cached pattern (incremental,
+  //the values are patched with K_new - K_old
+  //of the relinearised elements)
+  const bool incr = (elems != NULL);
+  if(incr and (elems->Size() == 0) and (Jacobian_f != NULL)) return;
+  if((not incr) or incr_rebuild) csr_assembler->Zero();
+  if(incr and incr_rebuild) *elMatsE = 0.0;
+  const mfem::real_t *h_B = IOp->GetMat().HostRead();
+  const Number *h_D = DE_Samp->Read(false);
+  mfem::real_t *h_K = incr? elMatsE->HostReadWrite(): NULL;
+  const int VS = VarSize, nD2 = nDofsMax*nDofsMax;
+  auto addElement = [&](const int IElm, mfem::DenseMatrix & Ke)
+  {
+    tElementMatricesE<Number,AccumNumber>(false, 1, nQuads, VS, nDofsMax, h_B
+                                        , h_D + IElm*nQuads*VS*VS, Ke.Data());
+    if(incr){
+      mfem::real_t *KOld = h_K + IElm*nD2, *KNew = Ke.Data();
+      for(int k=0; k<nD2; k++){ const mfem::real_t kNew = KNew[k];  KNew[k] -= KOld[k];  KOld[k] = kNew;};
+    }
+    csr_assembler->AddElementMatrix(IElm, Ke);
+  };
+
+  if(tHostThreads::GetNumThreads() <= 1){
+    const int nE = incr? elems->Size(): nElms;
+    for(int I=0; I<nE; I++) addElement(incr? (*elems)[I]: I, elMats);
+  }else{
+    //Coloured, the elements of a colour
+    //share no rows of the local CSR
+    std::vector<char> active(nElms, not incr);
+    if(incr) for(int I=0; I<elems->Size(); I++) active[(*elems)[I]] = 1;
+    const tElementColouring & colours = elem_restrict->GetColouring();
+    for(int IColour=0; IColour<colours.GetNColours(); IColour++){
+      const int *elms = colours.GetElms(IColour);
+      tHostForall(colours.GetNElms(IColour), [&](int Ie)
+      {
+        if(not active[elms[Ie]]) return;
+        thread_local mfem::DenseMatrix Ke;
+        Ke.SetSize(nDofsMax);
+        addElement(elms[Ie], Ke);
+      });
+    }
+  }
+  csr_assembler->Finalize();
+
+  //Apply the essential BC's
+  mfem::HypreParMatrix & J = csr_assembler->GetMatrix();
+  if(ess_bcs_tdofs.Size() != 0) J.EliminateBC(ess_bcs_tdofs, mfem::Operator::DIAG_ONE);
+  Jacobian_f = &J;
+};
+
+/*****************************************\
+!
+!  Cost-weighted repartitioning, the weight
+!  of an element is its measured evaluation
+!  time (1 if nothing was measured):
+!   -the elements of a nonconforming ParMesh
+!    are ordered along its space filling
+!    curve, each rank holds a contiguous
+!    range of the curve (a conforming one
+!    along the global element numbers)
+!   -the curve is cut into nRanks ranges of
+!    equal weight (prefix sum over the ranks)
+!   -the ParMesh migrates the elements, the
+!    FE-spaces and TrueVars are updated
+!  the element data of the form is rebuilt
+!  and the operator is re-prepared
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+bool tADNLForm<Number,AccumNumber>::WeightedPartition(const mfem::real_t imbalance_tol, mfem::Array<int> & partition) const
+{
+  const mfem::ParMesh *pmesh = ParFEs[0]->GetParMesh();
+  MPI_Comm comm = pmesh->GetComm();
+  const int nRanks = pmesh->GetNRanks();
+
+  //The element weights (a floor for the
+  //elements without evaluations)
+  const bool timed = (int(elmTimes.size()) == nElms);
+  double measured=0.0;
+  if(timed) for(int IElm=0; IElm<nElms; IElm++) measured += elmTimes[IElm];
+  MPI_Allreduce(MPI_IN_PLACE, &measured, 1, MPI_DOUBLE, MPI_SUM, comm);
+  const double wFloor = (measured > 0.0)? 1e-3*measured/pmesh->GetGlobalNE(): 1.0;
+  std::vector<double> w(nElms, wFloor);
+  if(timed and (measured > 0.0)) for(int IElm=0; IElm<nElms; IElm++) w[IElm] += elmTimes[IElm];
+
+  //The rank loads, only repartition
+  //beyond the imbalance tolerance
+  double load=0.0, total=0.0, maxLoad=0.0, offset=0.0;
+  for(int IElm=0; IElm<nElms; IElm++) load += w[IElm];
+  MPI_Allreduce(&load, &total,   1, MPI_DOUBLE, MPI_SUM, comm);
+  MPI_Allreduce(&load, &maxLoad, 1, MPI_DOUBLE, MPI_MAX, comm);
+  if(maxLoad <= imbalance_tol*total/nRanks) return false;
+  MPI_Exscan(&load, &offset, 1, MPI_DOUBLE, MPI_SUM, comm);
+  if(pmesh->GetMyRank() == 0) offset = 0.0;
+
+  //Cut the curve at the midpoints
+  //of the element weights
+  partition.SetSize(nElms);
+  for(int IElm=0; IElm<nElms; IElm++){
+    partition[IElm] = std::min(int(nRanks*(offset + 0.5*w[IElm])/total), nRanks-1);
+    offset += w[IElm];
+  }
+  return true;
+};
+
+template<typename Number, typename AccumNumber>
+bool tADNLForm<Number,AccumNumber>::Rebalance(const mfem::real_t imbalance_tol)
+{
+  //A conforming ParMesh can not migrate
+  //its elements (see RebalancedMesh)
+  mfem::ParMesh *pmesh = ParFEs[0]->GetParMesh();
+  if(not pmesh->Nonconforming()){
+    if(pmesh->GetMyRank() == 0) MFEM_WARNING("tADNLForm: Rebalance skipped, the ParMesh is conforming (use RebalancedMesh or Mesh::EnsureNCMesh)");
+    return false;
+  }
+  mfem::Array<int> partition;
+  if(not WeightedPartition(imbalance_tol, partition)) return false;
+
+  //Migrate the elements and the TrueVars
+  //(the FE-spaces can be shared)
+  pmesh->Rebalance(partition);
+  for(int I=0; I<ParFEs.Size(); I++) if(ParFEs.Find(ParFEs[I]) == I) ParFEs[I]->Update();
+  for(unsigned I=0; I<TrueVars.size(); I++) TrueVars[I]->Update();
+  for(int I=0; I<ParFEs.Size(); I++) if(ParFEs.Find(ParFEs[I]) == I) ParFEs[I]->UpdatesFinished();
+
+  //Rebuild the element data (the
+  //interpolator is per element type)
+  const int nDofsOld = nDofsMax;
+  SizeElements();
+  MFEM_VERIFY((nElms == 0) or (nDofsMax == nDofsOld), "tADNLForm: Rebalance changed the element type of the rank");
+  delete csr_assembler;  csr_assembler=NULL;
+  delete Jacobian_mf;    Jacobian_mf=NULL;
+  Jacobian_f=NULL;
+  ess_bcs_tdofs.SetSize(0);
+  activeElms.SetSize(0);
+  inactiveElms.SetSize(0);
+  VarIterUpdateFlag=true;
+  return true;
+};
+
+/*****************************************\
+!
+!  The weighted partition as a new ParMesh,
+!  the global mesh is gathered on rank 0
+!  (elements in the rank order, i.e. the
+!  global element numbers), broadcast and
+!  partitioned with the target ranks of
+!  every element
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+mfem::ParMesh * tADNLForm<Number,AccumNumber>::RebalancedMesh(const mfem::real_t imbalance_tol) const
+{
+  mfem::ParMesh *pmesh = ParFEs[0]->GetParMesh();
+  MPI_Comm comm = pmesh->GetComm();
+  const int nRanks = pmesh->GetNRanks(), myid = pmesh->GetMyRank();
+  mfem::Array<int> partition;
+  if(not WeightedPartition(imbalance_tol, partition)) return NULL;
+
+  //The target ranks of the global elements
+  std::vector<int> counts(nRanks), displs(nRanks, 0);
+  const int nLocal = partition.Size();
+  MPI_Allgather(&nLocal, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+  for(int I=1; I<nRanks; I++) displs[I] = displs[I-1] + counts[I-1];
+  mfem::Array<int> globalPartition(displs[nRanks-1] + counts[nRanks-1]);
+  MPI_Allgatherv(partition.GetData(), nLocal, MPI_INT, globalPartition.GetData(), counts.data(), displs.data(), MPI_INT, comm);
+
+  //The global mesh on every rank
+  std::string meshStr;
+  mfem::Mesh serial = pmesh->GetSerialMesh(0);
+  if(myid == 0){
+    std::ostringstream os;
+    os.precision(17);
+    serial.Print(os);
+    meshStr = os.str();
+  }
+  long long len = meshStr.size();
+  MPI_Bcast(&len, 1, MPI_LONG_LONG, 0, comm);
+  meshStr.resize(len);
+  MPI_Bcast(&meshStr[0], int(len), MPI_CHAR, 0, comm);
+  std::istringstream is(meshStr);
+  mfem::Mesh global(is);
+  return new mfem::ParMesh(comm, global, globalPartition.GetData());
+};
@@ -0,0 +1,102 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#include "mfem.hpp"
+#include <vector>
+
+
+/*****************************************\
+!
+!  Colouring of the elements such that no
+!  two elements of a colour share a local
+!  DOF, the elements of a colour can then
+!  scatter-add into the local DOF's (or a
+!  CSR row) in parallel without atomics
+!
+!  Greedy (first fit) in the element order
+!  over the local DOF -> elements graph of
+!  the gather map [nDofsMax x nElms] (the
+!  padding, sign 0, is not a DOF), the
+!  elements are stored colour by colour:
+!   colourElms[colourOffsets[IColour]..
+!              colourOffsets[IColour+1]]
+!  the sums of every local DOF are in a
+!  fixed (colour) order, i.e. independent
+!  of the number of threads, a subset of
+!  the elements (elems) can be coloured
+!  on its own
+!
+\*****************************************/
+class tElementColouring
+{
+  private:
+    mfem::Array<int> colourOffsets, colourElms;
+
+  public:
+    //Constructor (colours the elements)
+    tElementColouring(const mfem::Array<int> & gatherMap, const mfem::Array<mfem::real_t> & gatherSign
+                    , const int nElms, const int nDofsMax, const int nLDofs, const mfem::Array<int> *elems=NULL);
+
+    //The colours
+    int GetNColours() const {return colourOffsets.Size()-1;};
+    int GetNElms(const int IColour) const {return colourOffsets[IColour+1] - colourOffsets[IColour];};
+    const int *GetElms(const int IColour) const {return colourElms.HostRead() + colourOffsets[IColour];};
+};
+
+
+/*****************************************\
+!
+!  This implements the tElementColouring
+!  class
+!
+\*****************************************/
+inline tElementColouring::tElementColouring(const mfem::Array<int> & gatherMap, const mfem::Array<mfem::real_t> & gatherSign
+                                          , const int nElms, const int nDofsMax, const int nLDofs, const mfem::Array<int> *elems)
+{
+  const int *h_map = gatherMap.HostRead();
+  const mfem::real_t *h_sign = gatherSign.HostRead();
+  const int nE = (elems == NULL)? nElms: elems->Size();
+  const int *h_el = (elems == NULL)? NULL: elems->HostRead();
+
+  //Local DOF -> (listed) elements (CSR)
+  std::vector<int> dofElmOffs(nLDofs+1, 0), dofElms;
+  for(int Ie=0; Ie<nE; Ie++){
+    const int Ik0 = ((h_el == NULL)? Ie: h_el[Ie])*nDofsMax;
+    for(int K=0; K<nDofsMax; K++) if(h_sign[Ik0+K] != 0.0) dofElmOffs[h_map[Ik0+K]+1]++;
+  }
+  for(int I=0; I<nLDofs; I++) dofElmOffs[I+1] += dofElmOffs[I];
+  dofElms.resize(dofElmOffs[nLDofs]);
+  std::vector<int> fill(dofElmOffs.begin(), dofElmOffs.end()-1);
+  for(int Ie=0; Ie<nE; Ie++){
+    const int IElm = (h_el == NULL)? Ie: h_el[Ie];
+    for(int K=0; K<nDofsMax; K++) if(h_sign[IElm*nDofsMax+K] != 0.0) dofElms[fill[h_map[IElm*nDofsMax+K]]++] = IElm;
+  }
+
+  //First fit, the colours of the
+  //coloured neighbours are stamped
+  std::vector<int> colour(nElms,-1), stamp;
+  int nColours=0;
+  for(int Ie=0; Ie<nE; Ie++){
+    const int IElm = (h_el == NULL)? Ie: h_el[Ie];
+    for(int K=0; K<nDofsMax; K++){
+      const int Ik = IElm*nDofsMax + K;
+      if(h_sign[Ik] == 0.0) continue;
+      for(int J=dofElmOffs[h_map[Ik]]; J<dofElmOffs[h_map[Ik]+1]; J++){
+        const int c = colour[dofElms[J]];
+        if(c >= 0) stamp[c] = IElm;
+      }
+    }
+    int c=0;
+    while((c < nColours) and (stamp[c] == IElm)) c++;
+    if(c == nColours){ nColours++; stamp.push_back(-1);};
+    colour[IElm] = c;
+  }
+
+  //Sort the elements by colour
+  colourOffsets.SetSize(nColours+1);
+  colourOffsets = 0;
+  for(int IElm=0; IElm<nElms; IElm++) if(colour[IElm] >= 0) colourOffsets[colour[IElm]+1]++;
+  for(int c=0; c<nColours; c++) colourOffsets[c+1] += colourOffsets[c];
+  colourElms.SetSize(nE);
+  std::vector<int> pos(colourOffsets.begin(), colourOffsets.end()-1);
+  for(int IElm=0; IElm<nElms; IElm++) if(colour[IElm] >= 0) colourElms[pos[colour[IElm]]++] = IElm;
+};
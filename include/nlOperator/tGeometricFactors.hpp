@@ -0,0 +1,182 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#include "../UtilityObjects/tHostThreads.hpp"
+#include "mfem.hpp"
+#include <cmath>
+#include <vector>
+
+
+/*****************************************\
+!
+!  The (left) inverse of a Jacobian J
+!  [sdim x dim] (column-major) into invJ
+!  [dim x sdim] (row-major), returns the
+!  determinant (sqrt(det(J^T.J)) for the
+!  manifolds dim < sdim), the same as
+!  ElementTransformation::InverseJacobian
+!  and Weight
+!
+\*****************************************/
+MFEM_HOST_DEVICE inline mfem::real_t tInvertJacobian(const int dim, const int sdim, const mfem::real_t *J, mfem::real_t *invJ)
+{
+  //The square matrix A (J or J^T.J)
+  //and its adjugate (column-major)
+  mfem::real_t A[9], adj[9], det=0.0;
+  for(int I=0; I<dim; I++){
+    for(int K=0; K<dim; K++){
+      if(dim == sdim){
+        A[I + dim*K] = J[I + sdim*K];
+      }else{
+        A[I + dim*K] = 0.0;
+        for(int L=0; L<sdim; L++) A[I + dim*K] += J[L + sdim*I]*J[L + sdim*K];
+      }
+    }
+  }
+  if(dim == 1){
+    adj[0] = 1.0;
+    det = A[0];
+  }else if(dim == 2){
+    adj[0] =  A[3];  adj[2] = -A[2];
+    adj[1] = -A[1];  adj[3] =  A[0];
+    det = A[0]*A[3] - A[2]*A[1];
+  }else{
+    adj[0] = A[4]*A[8] - A[7]*A[5];  adj[3] = A[6]*A[5] - A[3]*A[8];  adj[6] = A[3]*A[7] - A[6]*A[4];
+    adj[1] = A[7]*A[2] - A[1]*A[8];  adj[4] = A[0]*A[8] - A[6]*A[2];  adj[7] = A[6]*A[1] - A[0]*A[7];
+    adj[2] = A[1]*A[5] - A[4]*A[2];  adj[5] = A[3]*A[2] - A[0]*A[5];  adj[8] = A[0]*A[4] - A[3]*A[1];
+    det = A[0]*adj[0] + A[3]*adj[1] + A[6]*adj[2];
+  }
+
+  //invJ = A^-1 (square) or
+  //A^-1.J^T (left inverse)
+  for(int I=0; I<dim; I++){
+    for(int K=0; K<sdim; K++){
+      mfem::real_t s=0.0;
+      if(dim == sdim){
+        s = adj[I + dim*K];
+      }else{
+        for(int L=0; L<dim; L++) s += adj[I + dim*L]*J[K + sdim*L];
+      }
+      invJ[I*sdim + K] = s/det;
+    }
+  }
+  return (dim == sdim)? det: std::sqrt(det);
+};
+
+
+/*****************************************\
+!
+!  Cache of the geometric factors of the
+!  elements at the points of each
+!  integration rule of a form (keyed by
+!  the rule ID, see AddIntegRule and
+!  TCoefficientIntegrator::GetIntegRule)
+!  in structure of arrays:
+!   W    [nQuads x nElms]  w.detJ
+!   invJ [nQuads x nElms] x dim.sdim, the
+!        component (I,J) of invJ at
+!        I*sdim + J
+!  from the batched Jacobians of
+!  Mesh::GetGeometricFactors (one loop, the
+!  device or the host threads)
+!
+!  The factors of a rule are only rebuilt
+!  when requested after the mesh changed:
+!   -refined/rebalanced (Mesh::GetSequence)
+!   -moved nodes (Mesh::GetNodesSequence,
+!    i.e. after Mesh::NodesUpdated)
+!  or after Invalidate()
+!
+\*****************************************/
+class tGeometricFactors
+{
+  private:
+    mfem::Mesh *mesh;
+    const bool & use_dev;
+    const mfem::MemoryType mt;
+
+    //The factors of a rule and the mesh
+    //state they were built on
+    struct tRuleFactors{
+      const mfem::IntegrationRule *ir=NULL;
+      long sequence=-1, nodesSequence=-1;
+      mfem::Vector W, invJ;
+    };
+    std::vector<tRuleFactors> rules;
+
+  public:
+    //Constructor
+    tGeometricFactors(mfem::Mesh *mesh_, const bool & use_dev_, const mfem::MemoryType mt_):
+                      mesh(mesh_), use_dev(use_dev_), mt(mt_){};
+
+    //The integration rule of an ID
+    void SetIntegRule(const unsigned ID, const mfem::IntegrationRule & ir);
+
+    //The factors of a rule match the mesh
+    bool IsValid(const unsigned ID) const;
+
+    //(Re)build the factors of a rule if
+    //they are invalid, returns true if
+    //they were (re)built
+    bool Update(const unsigned ID);
+
+    //Invalidate the factors of every rule
+    void Invalidate(){for(tRuleFactors & rf : rules) rf.sequence = rf.nodesSequence = -1;};
+
+    //The factors of a rule
+    const mfem::Vector & GetW(const unsigned ID) const {return rules[ID].W;};
+    const mfem::Vector & GetInvJ(const unsigned ID) const {return rules[ID].invJ;};
+};
+
+
+/*****************************************\
+!
+!  This implements the tGeometricFactors
+!  class
+!
+\*****************************************/
+inline void tGeometricFactors::SetIntegRule(const unsigned ID, const mfem::IntegrationRule & ir)
+{
+  if(rules.size() <= ID) rules.resize(ID+1);
+  rules[ID].ir = &ir;
+  rules[ID].sequence = rules[ID].nodesSequence = -1;
+};
+
+inline bool tGeometricFactors::IsValid(const unsigned ID) const
+{
+  const tRuleFactors & rf = rules[ID];
+  return (rf.sequence == mesh->GetSequence()) and (rf.nodesSequence == mesh->GetNodesSequence());
+};
+
+inline bool tGeometricFactors::Update(const unsigned ID)
+{
+  MFEM_VERIFY((ID < rules.size()) and (rules[ID].ir != NULL), "tGeometricFactors: unknown integration rule");
+  if(IsValid(ID)) return false;
+
+  tRuleFactors & rf = rules[ID];
+  const int NE = mesh->GetNE(), NQ = rf.ir->GetNPoints();
+  const int dim = mesh->Dimension(), sdim = mesh->SpaceDimension();
+  rf.W.SetSize(NQ*NE, mt);
+  rf.invJ.SetSize(NQ*NE*dim*sdim, mt);
+  if(NE > 0){
+    //The Jacobians [NQ x sdim x dim x NE]
+    //(cached by the mesh as well)
+    const mfem::GeometricFactors *geom = mesh->GetGeometricFactors(*rf.ir, mfem::GeometricFactors::JACOBIANS, mt);
+    const auto J = mfem::Reshape(geom->J.Read(use_dev), NQ, sdim, dim, NE);
+    const auto w = rf.ir->GetWeights().Read(use_dev);
+    auto W    = mfem::Reshape(rf.W.Write(use_dev), NQ, NE);
+    auto invJ = mfem::Reshape(rf.invJ.Write(use_dev), NQ, NE, dim*sdim);
+    tForall(use_dev, NQ*NE, [=] MFEM_HOST_DEVICE (int Iq)
+    {
+      const int Ip = Iq % NQ, IElm = Iq / NQ;
+      mfem::real_t Jq[9], invJq[9];
+      for(int K=0; K<dim; K++){
+        for(int L=0; L<sdim; L++) Jq[L + sdim*K] = J(Ip,L,K,IElm);
+      }
+      W(Ip,IElm) = w[Ip]*tInvertJacobian(dim, sdim, Jq, invJq);
+      for(int K=0; K<dim*sdim; K++) invJ(Ip,IElm,K) = invJq[K];
+    });
+  }
+  rf.sequence      = mesh->GetSequence();
+  rf.nodesSequence = mesh->GetNodesSequence();
+  return true;
+};
@@ -1,7 +1,9 @@
 #pragma once
 #include "../UtilityObjects/macros.hpp"
 #include "../UtilityObjects/lowLevelMFEM.hpp"
+#include "../UtilityObjects/tHostThreads.hpp"
 #include "mfem.hpp"
+#include <vector>
 
 
 /*****************************************\
@@ -11,17 +13,225 @@
 !  grid functions etc... to convert from
 !  discrete data to sampled continuous data
 !
+!  The lumped (isogeometric) interpolator
+!  Q_Iso [nSamp x nDofsMax] maps the
+!  element vector to the sampled Vars,
+!  a sample is (Ip, IVar-component):
+!   ISamp = Ip*VarSize + VarOffset + IComp
+!  so the Vars of an integration point are
+!  contiguous. Each Var adds its own block
+!  [nQuads*TVarSize x nDofsParent] ordered
+!  (Ip, IComp) x (parent element DOF's)
+!
 \*****************************************/
-class tInterpolator : public mfem::DenseMatrix
+class tInterpolator
 {
   private:
-    const mfem::Array<mfem::ParGridFunction*> & ParGFS;
+    //The Var blocks
+    struct InterpBlock{
+      int VarOffset, TVarSize, DofOffset;
+      mfem::DenseMatrix Q;
+    };
+    std::vector<InterpBlock> blocks;
     mfem::DenseMatrix IOp;
+    int nQuads=0;
 
   public:
     //Constructor
-    tInterpolator();
+    tInterpolator(){};
+
+    //Add the interpolator of a Var
+    void AddInterpolator(const int VarOffset, const int TVarSize, const int DofOffset
+                       , const mfem::DenseMatrix & InterpOp);
+
+    //Remove all the Var blocks
+    void Clear(){blocks.clear(); nQuads=0; IOp.SetSize(0,0);};
+
+    //Build the lumped interpolator
+    void Assemble(const int VarSize, const int nDofsMax);
+
+    //Number of integration points
+    int GetNQuads() const {return nQuads;};
 
     //Get the interpolation matrix
     mfem::DenseMatrix & GetMat(){return IOp;};
+    const mfem::DenseMatrix & GetMat() const {return IOp;};
+
+    //Interpolators of common Vars [nQuads*vdim(*dim) x vdim*nDof]
+    //the values u and the reference gradients du/dxi
+    static void ShapeValues(const mfem::FiniteElement & fe, const int vdim
+                          , const mfem::IntegrationRule & ir, mfem::DenseMatrix & Q);
+    static void ShapeGrads(const mfem::FiniteElement & fe, const int vdim
+                         , const mfem::IntegrationRule & ir, mfem::DenseMatrix & Q);
+};
+
+
+/*****************************************\
+!
+!  This implements the tInterpolator
+!  class
+!
+\*****************************************/
+//Add the interpolator of a Var
+inline void tInterpolator::AddInterpolator(const int VarOffset, const int TVarSize, const int DofOffset
+                                         , const mfem::DenseMatrix & InterpOp)
+{
+  const int nQuadsVar = InterpOp.Height()/TVarSize;
+  MFEM_VERIFY(nQuadsVar*TVarSize == InterpOp.Height(), "tInterpolator: rows are not nQuads*TVarSize");
+  MFEM_VERIFY((nQuads == 0) or (nQuads == nQuadsVar), "tInterpolator: Vars sampled at different points");
+  nQuads = nQuadsVar;
+  blocks.push_back({VarOffset, TVarSize, DofOffset, InterpOp});
+};
+
+//Build the lumped interpolator
+inline void tInterpolator::Assemble(const int VarSize, const int nDofsMax)
+{
+  IOp.SetSize(nQuads*VarSize, nDofsMax);
+  IOp = 0.0;
+  for(const InterpBlock & block : blocks){
+    for(int Ip=0; Ip<nQuads; Ip++){
+      for(int IComp=0; IComp<block.TVarSize; IComp++){
+        const int ISamp = Ip*VarSize + block.VarOffset + IComp;
+        for(int JDof=0; JDof<block.Q.Width(); JDof++){
+          IOp(ISamp, block.DofOffset + JDof) = block.Q(Ip*block.TVarSize + IComp, JDof);
+        }
+      }
+    }
+  }
+};
+
+//Shape function values (element vdofs are
+//ordered by components [c*nDof + k])
+inline void tInterpolator::ShapeValues(const mfem::FiniteElement & fe, const int vdim
+                                     , const mfem::IntegrationRule & ir, mfem::DenseMatrix & Q)
+{
+  const int nDof = fe.GetDof(), nQ = ir.GetNPoints();
+  mfem::Vector shape(nDof);
+  Q.SetSize(nQ*vdim, nDof*vdim);
+  Q = 0.0;
+  for(int Ip=0; Ip<nQ; Ip++){
+    fe.CalcShape(ir.IntPoint(Ip), shape);
+    for(int c=0; c<vdim; c++){
+      for(int k=0; k<nDof; k++) Q(Ip*vdim + c, c*nDof + k) = shape(k);
+    }
+  }
+};
+
+//Shape function reference gradients
+//sample (Ip, c, d) is du_c/dxi_d
+inline void tInterpolator::ShapeGrads(const mfem::FiniteElement & fe, const int vdim
+                                    , const mfem::IntegrationRule & ir, mfem::DenseMatrix & Q)
+{
+  const int nDof = fe.GetDof(), nQ = ir.GetNPoints(), dim = fe.GetDim();
+  mfem::DenseMatrix dshape(nDof, dim);
+  Q.SetSize(nQ*vdim*dim, nDof*vdim);
+  Q = 0.0;
+  for(int Ip=0; Ip<nQ; Ip++){
+    fe.CalcDShape(ir.IntPoint(Ip), dshape);
+    for(int c=0; c<vdim; c++){
+      for(int d=0; d<dim; d++){
+        for(int k=0; k<nDof; k++) Q((Ip*vdim + c)*dim + d, c*nDof + k) = dshape(k,d);
+      }
+    }
+  }
+};
+
+
+/*****************************************\
+!
+!  Batched (element-wise) interpolation
+!  of the element vectors to the sampled
+!  Vars and its transpose, B is the
+!  [nSamp x nDofs] interpolator:
+!   xSamp_e = B.xE_e   rE_e = B^T.rSamp_e
+!  The sums are done in AccumNumber, the
+!  samples are stored (rounded once) in the
+!  evaluation precision Number
+!
+!  (only the elements of a list, elems,
+!  when given)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tInterpolateE(const bool use_dev, const int nElms, const int nSamp, const int nDofs
+                 , const mfem::real_t *B, const mfem::real_t *xE, Number *xSamp, const int *elems=NULL)
+{
+  const auto d_B = mfem::Reshape(B, nSamp, nDofs);
+  tForall(use_dev, nElms*nSamp, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int IElm = (elems == NULL)? Ik / nSamp: elems[Ik / nSamp], ISamp = Ik % nSamp;
+    const mfem::real_t *xE_e = xE + IElm*nDofs;
+    AccumNumber sum(0.0);
+    for(int JDof=0; JDof<nDofs; JDof++) sum += AccumNumber(d_B(ISamp,JDof))*AccumNumber(xE_e[JDof]);
+    xSamp[IElm*nSamp + ISamp] = Number(sum);
+  });
+};
+
+template<typename Number, typename AccumNumber>
+void tInterpolateTransposeE(const bool use_dev, const int nElms, const int nSamp, const int nDofs
+                          , const mfem::real_t *B, const Number *rSamp, mfem::real_t *rE, const int *elems=NULL)
+{
+  const auto d_B = mfem::Reshape(B, nSamp, nDofs);
+  tForall(use_dev, nElms*nDofs, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int IElm = (elems == NULL)? Ik / nDofs: elems[Ik / nDofs], JDof = Ik % nDofs;
+    const Number *rSamp_e = rSamp + IElm*nSamp;
+    AccumNumber sum(0.0);
+    for(int ISamp=0; ISamp<nSamp; ISamp++) sum += AccumNumber(d_B(ISamp,JDof))*AccumNumber(rSamp_e[ISamp]);
+    rE[IElm*nDofs + JDof] = mfem::real_t(sum);
+  });
+};
+
+
+/*****************************************\
+!
+!  Batched element matrices of the sampled
+!  Hessians D_p [VarSize x VarSize] (B_p are
+!  the rows Ip*VarSize.. of B):
+!   K_e = sum_p B_p^T.D_p.B_p
+!  stored [nDofs x nDofs x nElms], and the
+!  batched element matrix-vector product
+!   yE_e = K_e.xE_e
+!  K_e is symmetric (the Hessian of an
+!  energy) so each row is read as a
+!  contiguous column, the element matrices
+!  can be (re)built for a list of nElms
+!  elements only (elems, NULL for 0..nElms)
+!
+\*****************************************/
+template<typename Number, typename AccumNumber>
+void tElementMatricesE(const bool use_dev, const int nElms, const int nQuads, const int VarSize, const int nDofs
+                     , const mfem::real_t *B, const Number *D, mfem::real_t *K, const int *elems=NULL)
+{
+  const auto d_B = mfem::Reshape(B, nQuads*VarSize, nDofs);
+  tForall(use_dev, nElms*nDofs, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int IElm = (elems == NULL)? Ik / nDofs: elems[Ik / nDofs], JDof = Ik % nDofs;
+    const auto d_D = mfem::Reshape(D + IElm*VarSize*VarSize*nQuads, VarSize, VarSize, nQuads);
+    auto d_K       = mfem::Reshape(K + IElm*nDofs*nDofs, nDofs, nDofs);
+    for(int IDof=0; IDof<nDofs; IDof++) d_K(IDof,JDof) = 0.0;
+    for(int Ip=0; Ip<nQuads; Ip++){
+      for(int I=0; I<VarSize; I++){
+        AccumNumber DB(0.0);
+        for(int J=0; J<VarSize; J++) DB += AccumNumber(d_D(J,I,Ip))*AccumNumber(d_B(Ip*VarSize + J,JDof));
+        for(int IDof=0; IDof<nDofs; IDof++) d_K(IDof,JDof) += mfem::real_t(AccumNumber(d_B(Ip*VarSize + I,IDof))*DB);
+      }
+    }
+  });
+};
+
+template<typename AccumNumber>
+void tElementMultE(const bool use_dev, const int nElms, const int nDofs
+                 , const mfem::real_t *K, const mfem::real_t *xE, mfem::real_t *yE)
+{
+  const auto d_K  = mfem::Reshape(K, nDofs, nDofs, nElms);
+  const auto d_xE = mfem::Reshape(xE, nDofs, nElms);
+  auto d_yE       = mfem::Reshape(yE, nDofs, nElms);
+  tForall(use_dev, nElms*nDofs, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int IElm = Ik / nDofs, IDof = Ik % nDofs;
+    AccumNumber sum(0.0);
+    for(int JDof=0; JDof<nDofs; JDof++) sum += AccumNumber(d_K(JDof,IDof,IElm))*AccumNumber(d_xE(JDof,IElm));
+    d_yE(IDof,IElm) = mfem::real_t(sum);
+  });
 };
@@ -0,0 +1,388 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#include "../UtilityObjects/lowLevelMFEM.hpp"
+#include "tRestrictOperator.hpp"
+#include "mfem.hpp"
+#include <vector>
+#include <map>
+#include <algorithm>
+
+
+/*****************************************\
+!
+!  Assembles the element matrices of all
+!  the Vars into a single HypreParMatrix
+!  (over the true DOF's of the form) with
+!  a cached sparsity pattern
+!
+!  Built once (pattern and scatter maps):
+!   -elemMap : element matrix entry ->
+!              local (ldof) CSR entry
+!              (-1 for the padding)
+!   -local CSR entry -> HypreParMatrix
+!    diag/offd entry (owned rows) or a
+!    send slot (rows owned by another
+!    rank), weighted by the prolongation
+!   -receive slot -> diag/offd entry
+!  Every later assembly only overwrites
+!  the values in place (no reallocation,
+!  no sorting and no new hypre object)
+!
+!  The true DOF's of the form are numbered
+!  rank by rank, each rank holds its true
+!  DOF's of every Var in turn
+!
+\*****************************************/
+template<typename UINT>
+class tParCSRAssembler
+{
+  private:
+    const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs;
+    const tRestrictOperator<UINT> & elem_restrict;
+    MPI_Comm comm;
+    int nRanks=1, myRank=0;
+
+    //Local (ldof) CSR matrix
+    std::vector<int>          A_I, A_J;
+    std::vector<mfem::real_t> A_data;
+    std::vector<int>          elemMap;
+
+    //The true DOF partitioning
+    std::vector<HYPRE_BigInt> combStarts, rowStarts;
+    std::vector<std::vector<HYPRE_BigInt>> varStarts, varInnerOffs;
+
+    //Local CSR -> owned entries
+    std::vector<int> locSrc, locDst;
+    std::vector<mfem::real_t> locW;
+
+    //Local CSR -> send slots, receive
+    //slots -> owned entries
+    std::vector<int> sendSrc, sendSlot, sendCounts, sendOffs;
+    std::vector<mfem::real_t> sendW, sendVals;
+    std::vector<int> recvDst, recvCounts, recvOffs;
+    std::vector<mfem::real_t> recvVals;
+
+    //The Jacobian and its (aliased)
+    //diagonal and off-diagonal blocks
+    mfem::HypreParMatrix *Jacobian=NULL;
+    mfem::SparseMatrix   diag, offd;
+    HYPRE_BigInt         *cmap=NULL;
+
+    //Global combined true DOF of
+    //true DOF g of Var IVar
+    HYPRE_BigInt CombinedTDof(const UINT IVar, const HYPRE_BigInt g) const;
+    int Owner(const HYPRE_BigInt G) const;
+
+    //Entry of the (G,H) owned pair in the
+    //diag (idx) or offd (nnzDiag + idx) data
+    int OwnedEntry(const HYPRE_BigInt G, const HYPRE_BigInt H) const;
+
+  public:
+    //Constructor (builds the pattern)
+    tParCSRAssembler(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_
+                   , const tRestrictOperator<UINT> & elem_restrict_);
+
+    //Destructor
+    ~tParCSRAssembler(){delete Jacobian;};
+
+    //Zero the local values
+    void Zero(){std::fill(A_data.begin(), A_data.end(), 0.0);};
+
+    //Add an element matrix [nDofsMax x nDofsMax]
+    //(in the signed element DOF's)
+    void AddElementMatrix(const UINT IElm, const mfem::DenseMatrix & elMat);
+
+    //Overwrite the HypreParMatrix values
+    //with the summed local values
+    void Finalize();
+
+    //Get the Jacobian
+    mfem::HypreParMatrix & GetMatrix(){return *Jacobian;};
+
+    //Number of local CSR entries
+    int GetLocalNNZ() const {return A_J.size();};
+};
+
+
+/*****************************************\
+!
+!  This implements the tParCSRAssembler
+!  class
+!
+\*****************************************/
+//Global combined true DOF
+template<typename UINT>
+HYPRE_BigInt tParCSRAssembler<UINT>::CombinedTDof(const UINT IVar, const HYPRE_BigInt g) const
+{
+  const std::vector<HYPRE_BigInt> & vs = varStarts[IVar];
+  const int r = std::upper_bound(vs.begin(), vs.end(), g) - vs.begin() - 1;
+  return combStarts[r] + varInnerOffs[r][IVar] + (g - vs[r]);
+};
+
+//Owner rank of a combined true DOF
+template<typename UINT>
+int tParCSRAssembler<UINT>::Owner(const HYPRE_BigInt G) const
+{
+  return std::upper_bound(combStarts.begin(), combStarts.end(), G) - combStarts.begin() - 1;
+};
+
+//Entry of an owned pair (hypre diag
+//rows are not sorted, linear search)
+template<typename UINT>
+int tParCSRAssembler<UINT>::OwnedEntry(const HYPRE_BigInt G, const HYPRE_BigInt H) const
+{
+  const int row = G - combStarts[myRank];
+  if((H >= combStarts[myRank]) and (H < combStarts[myRank+1])){
+    const int col = H - combStarts[myRank];
+    for(int k=diag.GetI()[row]; k<diag.GetI()[row+1]; k++) if(diag.GetJ()[k] == col) return k;
+  }else{
+    for(int k=offd.GetI()[row]; k<offd.GetI()[row+1]; k++) if(cmap[offd.GetJ()[k]] == H) return diag.NumNonZeroElems() + k;
+  }
+  MFEM_ABORT("tParCSRAssembler: entry missing from the sparsity pattern");
+  return -1;
+};
+
+// The constructor
+template<typename UINT>
+tParCSRAssembler<UINT>::tParCSRAssembler(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_
+                                       , const tRestrictOperator<UINT> & elem_restrict_):
+                                         ParFEs(ParFEs_), elem_restrict(elem_restrict_)
+{
+  const UINT nVars = ParFEs.Size();
+  const UINT nElms = elem_restrict.GetNElms(), nD = elem_restrict.GetNDofsMax();
+  const int nL = elem_restrict.GetLocalDofOffset(nVars);
+  comm = ParFEs[0]->GetComm();
+  MPI_Comm_size(comm, &nRanks);
+  MPI_Comm_rank(comm, &myRank);
+
+  //////////////////////////
+  ///Local (ldof) pattern and
+  ///the element scatter map
+  //////////////////////////
+  const int *h_map = elem_restrict.GetGatherMap().HostRead();
+  const mfem::real_t *h_sign = elem_restrict.GetGatherSign().HostRead();
+  std::vector<std::vector<int>> rowCols(nL);
+  for(UINT IElm=0; IElm<nElms; IElm++){
+    for(UINT a=0; a<nD; a++){
+      if(h_sign[IElm*nD + a] == 0.0) continue;
+      for(UINT b=0; b<nD; b++){
+        if(h_sign[IElm*nD + b] != 0.0) rowCols[h_map[IElm*nD + a]].push_back(h_map[IElm*nD + b]);
+      }
+    }
+  }
+  A_I.assign(nL+1, 0);
+  for(int i=0; i<nL; i++){
+    std::sort(rowCols[i].begin(), rowCols[i].end());
+    rowCols[i].erase(std::unique(rowCols[i].begin(), rowCols[i].end()), rowCols[i].end());
+    A_I[i+1] = A_I[i] + rowCols[i].size();
+    A_J.insert(A_J.end(), rowCols[i].begin(), rowCols[i].end());
+  }
+  A_data.assign(A_J.size(), 0.0);
+  rowCols.clear();
+
+  elemMap.assign(nElms*nD*nD, -1);
+  for(UINT IElm=0; IElm<nElms; IElm++){
+    for(UINT a=0; a<nD; a++){
+      if(h_sign[IElm*nD + a] == 0.0) continue;
+      const int i = h_map[IElm*nD + a];
+      for(UINT b=0; b<nD; b++){
+        if(h_sign[IElm*nD + b] == 0.0) continue;
+        const int *Jb = A_J.data() + A_I[i], *Je = A_J.data() + A_I[i+1];
+        elemMap[(IElm*nD + a)*nD + b] = std::lower_bound(Jb, Je, h_map[IElm*nD + b]) - A_J.data();
+      }
+    }
+  }
+
+  //////////////////////////
+  ///True DOF partitioning of
+  ///every Var on every rank
+  //////////////////////////
+  std::vector<long long> nTDofsLoc(nVars), nTDofs(nVars*nRanks);
+  for(UINT I=0; I<nVars; I++) nTDofsLoc[I] = ParFEs[I]->GetTrueVSize();
+  MPI_Allgather(nTDofsLoc.data(), nVars, MPI_LONG_LONG, nTDofs.data(), nVars, MPI_LONG_LONG, comm);
+  combStarts.assign(nRanks+1, 0);
+  varStarts.assign(nVars, std::vector<HYPRE_BigInt>(nRanks+1, 0));
+  varInnerOffs.assign(nRanks, std::vector<HYPRE_BigInt>(nVars, 0));
+  for(int r=0; r<nRanks; r++){
+    HYPRE_BigInt inner=0;
+    for(UINT I=0; I<nVars; I++){
+      varInnerOffs[r][I]  = inner;
+      varStarts[I][r+1]   = varStarts[I][r] + nTDofs[r*nVars + I];
+      inner              += nTDofs[r*nVars + I];
+    }
+    combStarts[r+1] = combStarts[r] + inner;
+  }
+  if(HYPRE_AssumedPartitionCheck()){
+    rowStarts = {combStarts[myRank], combStarts[myRank+1], combStarts[nRanks]};
+  }else{
+    rowStarts = combStarts;
+  }
+
+  //////////////////////////
+  ///Prolongation rows, ldof ->
+  ///combined true DOF's (weights)
+  //////////////////////////
+  std::vector<int> PI(nL+1, 0);
+  std::vector<HYPRE_BigInt> PJ;
+  std::vector<mfem::real_t> PW;
+  for(UINT I=0; I<nVars; I++){
+    mfem::SparseMatrix Pd, Po;
+    HYPRE_BigInt *Pcmap=NULL;
+    const mfem::HypreParMatrix *P = ParFEs[I]->Dof_TrueDof_Matrix();
+    P->GetDiag(Pd);
+    P->GetOffd(Po, Pcmap);
+    const HYPRE_BigInt myOff = ParFEs[I]->GetMyTDofOffset();
+    const int ldofOff = elem_restrict.GetLocalDofOffset(I);
+    for(int l=0; l<ParFEs[I]->GetVSize(); l++){
+      for(int k=Pd.GetI()[l]; k<Pd.GetI()[l+1]; k++){
+        PJ.push_back(CombinedTDof(I, myOff + Pd.GetJ()[k]));
+        PW.push_back(Pd.GetData()[k]);
+      }
+      if(Po.Height() > 0){
+        for(int k=Po.GetI()[l]; k<Po.GetI()[l+1]; k++){
+          PJ.push_back(CombinedTDof(I, Pcmap[Po.GetJ()[k]]));
+          PW.push_back(Po.GetData()[k]);
+        }
+      }
+      PI[ldofOff + l + 1] = PJ.size();
+    }
+  }
+
+  //////////////////////////
+  ///Expand the local entries
+  ///onto the owned rows and the
+  ///send slots (unique pairs)
+  //////////////////////////
+  typedef std::pair<HYPRE_BigInt,HYPRE_BigInt> tPair;
+  std::vector<tPair> locPairs;
+  std::vector<std::map<tPair,int>> sendPairs(nRanks);
+  std::vector<int> sendRank;
+  for(int i=0; i<nL; i++){
+    for(int k=A_I[i]; k<A_I[i+1]; k++){
+      const int j = A_J[k];
+      for(int p=PI[i]; p<PI[i+1]; p++){
+        const int r = Owner(PJ[p]);
+        for(int q=PI[j]; q<PI[j+1]; q++){
+          const tPair GH(PJ[p], PJ[q]);
+          if(r == myRank){
+            locPairs.push_back(GH);
+            locSrc.push_back(k);
+            locW.push_back(PW[p]*PW[q]);
+          }else{
+            auto it = sendPairs[r].emplace(GH, int(sendPairs[r].size())).first;
+            sendSrc.push_back(k);
+            sendSlot.push_back(it->second);
+            sendRank.push_back(r);
+            sendW.push_back(PW[p]*PW[q]);
+          }
+        }
+      }
+    }
+  }
+
+  //////////////////////////
+  ///Exchange the send pairs
+  //////////////////////////
+  sendCounts.assign(nRanks, 0);  sendOffs.assign(nRanks+1, 0);
+  recvCounts.assign(nRanks, 0);  recvOffs.assign(nRanks+1, 0);
+  for(int r=0; r<nRanks; r++) sendCounts[r] = sendPairs[r].size();
+  MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm);
+  for(int r=0; r<nRanks; r++){
+    sendOffs[r+1] = sendOffs[r] + sendCounts[r];
+    recvOffs[r+1] = recvOffs[r] + recvCounts[r];
+  }
+  for(unsigned k=0; k<sendSlot.size(); k++) sendSlot[k] += sendOffs[sendRank[k]];
+
+  std::vector<long long> sendBuf(2*sendOffs[nRanks]), recvBuf(2*recvOffs[nRanks]);
+  for(int r=0; r<nRanks; r++){
+    for(const auto & GH : sendPairs[r]){
+      sendBuf[2*(sendOffs[r] + GH.second)]     = GH.first.first;
+      sendBuf[2*(sendOffs[r] + GH.second) + 1] = GH.first.second;
+    }
+  }
+  std::vector<int> sc2(nRanks), so2(nRanks), rc2(nRanks), ro2(nRanks);
+  for(int r=0; r<nRanks; r++){
+    sc2[r] = 2*sendCounts[r];  so2[r] = 2*sendOffs[r];
+    rc2[r] = 2*recvCounts[r];  ro2[r] = 2*recvOffs[r];
+  }
+  MPI_Alltoallv(sendBuf.data(), sc2.data(), so2.data(), MPI_LONG_LONG
+              , recvBuf.data(), rc2.data(), ro2.data(), MPI_LONG_LONG, comm);
+  sendPairs.clear();
+  sendVals.assign(sendOffs[nRanks], 0.0);
+  recvVals.assign(recvOffs[nRanks], 0.0);
+
+  //////////////////////////
+  ///Owned rows pattern, build
+  ///the HypreParMatrix (once)
+  //////////////////////////
+  const int nRows = combStarts[myRank+1] - combStarts[myRank];
+  std::vector<std::vector<HYPRE_BigInt>> ownedCols(nRows);
+  for(const tPair & GH : locPairs) ownedCols[GH.first - combStarts[myRank]].push_back(GH.second);
+  for(int k=0; k<recvOffs[nRanks]; k++) ownedCols[recvBuf[2*k] - combStarts[myRank]].push_back(recvBuf[2*k+1]);
+  std::vector<int> J_I(nRows+1, 0);
+  std::vector<HYPRE_BigInt> J_J;
+  for(int i=0; i<nRows; i++){
+    std::sort(ownedCols[i].begin(), ownedCols[i].end());
+    ownedCols[i].erase(std::unique(ownedCols[i].begin(), ownedCols[i].end()), ownedCols[i].end());
+    J_I[i+1] = J_I[i] + ownedCols[i].size();
+    J_J.insert(J_J.end(), ownedCols[i].begin(), ownedCols[i].end());
+  }
+  ownedCols.clear();
+  std::vector<mfem::real_t> J_data(J_J.size(), 0.0);
+  Jacobian = new mfem::HypreParMatrix(comm, nRows, combStarts[nRanks], combStarts[nRanks]
+                                    , J_I.data(), J_J.data(), J_data.data()
+                                    , rowStarts.data(), rowStarts.data());
+  Jacobian->GetDiag(diag);
+  Jacobian->GetOffd(offd, cmap);
+
+  //////////////////////////
+  ///Entries of the owned and
+  ///received pairs
+  //////////////////////////
+  locDst.resize(locPairs.size());
+  for(unsigned k=0; k<locPairs.size(); k++) locDst[k] = OwnedEntry(locPairs[k].first, locPairs[k].second);
+  recvDst.resize(recvOffs[nRanks]);
+  for(int k=0; k<recvOffs[nRanks]; k++) recvDst[k] = OwnedEntry(recvBuf[2*k], recvBuf[2*k+1]);
+};
+
+
+// Add an element matrix
+template<typename UINT>
+void tParCSRAssembler<UINT>::AddElementMatrix(const UINT IElm, const mfem::DenseMatrix & elMat)
+{
+  const UINT nD = elem_restrict.GetNDofsMax();
+  const mfem::real_t *h_sign = elem_restrict.GetGatherSign().HostRead();
+  const mfem::real_t *sE = h_sign + IElm*nD;
+  const int *mapE = elemMap.data() + IElm*nD*nD;
+  for(UINT a=0; a<nD; a++){
+    for(UINT b=0; b<nD; b++){
+      const int k = mapE[a*nD + b];
+      if(k >= 0) A_data[k] += sE[a]*sE[b]*elMat(a,b);
+    }
+  }
+};
+
+
+// Overwrite the HypreParMatrix values
+template<typename UINT>
+void tParCSRAssembler<UINT>::Finalize()
+{
+  //Owned rows
+  Jacobian->HostReadWrite();
+  mfem::real_t *d_diag = diag.GetData(), *d_offd = offd.GetData();
+  const int nnzDiag = diag.NumNonZeroElems();
+  std::fill(d_diag, d_diag + nnzDiag, 0.0);
+  std::fill(d_offd, d_offd + offd.NumNonZeroElems(), 0.0);
+  auto addOwned = [&](const int dst, const mfem::real_t val){
+    if(dst < nnzDiag){ d_diag[dst] += val;} else{ d_offd[dst - nnzDiag] += val;}
+  };
+  for(unsigned k=0; k<locSrc.size(); k++) addOwned(locDst[k], locW[k]*A_data[locSrc[k]]);
+
+  //Rows owned by other ranks
+  std::fill(sendVals.begin(), sendVals.end(), 0.0);
+  for(unsigned k=0; k<sendSrc.size(); k++) sendVals[sendSlot[k]] += sendW[k]*A_data[sendSrc[k]];
+  MPI_Alltoallv(sendVals.data(), sendCounts.data(), sendOffs.data(), MFEM_MPI_REAL_T
+              , recvVals.data(), recvCounts.data(), recvOffs.data(), MFEM_MPI_REAL_T, comm);
+  for(unsigned k=0; k<recvDst.size(); k++) addOwned(recvDst[k], recvVals[k]);
+  Jacobian->HypreReadWrite();
+};
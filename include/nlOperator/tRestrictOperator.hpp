@@ -1,18 +1,56 @@
 #pragma once
 #include "../UtilityObjects/macros.hpp"
 #include "../UtilityObjects/lowLevelMFEM.hpp"
+#include "../UtilityObjects/tHostThreads.hpp"
+#include "tElementColouring.hpp"
 #include "mfem.hpp"
 
 
 /*****************************************\
 !
-!  This generates a single restriction 
+!  This generates a single restriction
 !  operator that acts over all the Vars
 !  to give the element vectors. (This is
-!  for the total mesh level local 
-!  restrictions on sub topologies on 
+!  for the total mesh level local
+!  restrictions on sub topologies on
 !  multi-meshes are handled internally by
-!  the Var-FE-spaces) 
+!  the Var-FE-spaces)
+!
+!  The true DOF's of each Var are
+!  prolongated to its local DOF's and
+!  gathered into the element vectors
+!  [nDofsMax x nElms], element IElm holds
+!  the element DOF's of every Var in turn:
+!   [Var_0 DOF's | Var_1 DOF's | ...]
+!  each padded to the Vars largest element
+!  The gather map holds the local DOF of
+!  each entry and its sign (-1 for the
+!  flipped DOF's of ND/RT spaces, 0 for
+!  the padding)
+!
+!  With host threads the transpose is
+!  scatter-added colour by colour (see
+!  tElementColouring), without atomics
+!
+!  Split phase (overlapped) exchanges, for
+!  the conforming (group communicator)
+!  prolongations on the host:
+!   MultBegin   : owned local DOF's, post
+!                 the halo broadcast
+!   MultEnd     : receive the halo
+!   MultTransposeBegin : post the reduction
+!                 of the shared local DOF's
+!   MultTransposeEnd   : sum the reduction,
+!                 owned local -> true DOF's
+!  the elements are split into the interior
+!  sets (no shared local DOF's, gathered
+!  any time after MultBegin and scattered
+!  any time before MultTransposeEnd, two
+!  halves to overlap both exchanges) and
+!  the interface set (gathered after
+!  MultEnd and scattered before
+!  MultTransposeBegin), the other
+!  prolongations are applied blocking
 !
 \*****************************************/
 template<typename UINT>
@@ -20,23 +58,84 @@ class tRestrictOperator : public mfem::Operator
 {
   private:
     const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs;
-    mfem::Array<UINT> row_offsets, column_offsets;
-    mfem::BlockOperator *blockRestriction;
+    mfem::Array<UINT> tdof_offsets, ldof_offsets, edof_offsets;
+
+    //Element gather map
+    mfem::Array<int>    gatherMap;
+    mfem::Array<mfem::real_t> gatherSign;
+    mutable mfem::Vector xL, yL;
+
+    //Split phase exchanges, owned local
+    //-> true DOF's, the first Var of each
+    //group communicator and the element sets
+    bool overlap=false;
+    mfem::Array<int> ownL, ownT;
+    mfem::Array<bool> gcFirst;
+    mfem::Array<int> elemSets[3];
+
+    //Element colourings (all, sets)
+    mutable tElementColouring *colourings[4]={NULL,NULL,NULL,NULL};
+
+    //Problem sizing
+    UINT nElms=0, nDofsMax=0;
+    const bool use_dev;
 
     UINT OperatorSizeM(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_);
     UINT OperatorSizeN(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_);
+
+    //Gather/scatter-add the elements of
+    //a set (-1, every element)
+    const mfem::Array<int> *ElementSet(const int ISet) const {return (ISet < 0)? NULL: &elemSets[ISet];};
+    void Gather(const int ISet, mfem::Vector & y) const;
+    void Scatter(const int ISet, const mfem::Vector & x) const;
+
   public:
+    //The element sets
+    enum ElementSets{INTERIOR_A=0, INTERIOR_B=1, INTERFACE=2};
+
     //Constructor
-    tRestrictOperator(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_);
+    tRestrictOperator(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_, const bool use_dev_=false);
 
     //Destructor
-    ~tRestrictOperator();
+    ~tRestrictOperator(){for(int I=0; I<4; I++) delete colourings[I];};
 
-    //Get the operator
+    //Restrict the true DOF's to the element vectors
     void Mult(const mfem::Vector & x, mfem::Vector & y) const;
 
-    //Get the operator
-    mfem::Operator & GetGradient() const;
+    //Sum the element vectors into the true DOF's
+    void MultTranspose(const mfem::Vector & x, mfem::Vector & y) const;
+
+    //Split phase restriction, the elements
+    //of a set are gathered into y
+    void MultBegin(const mfem::Vector & x) const;
+    void MultEnd() const;
+    void MultElements(const int ISet, mfem::Vector & y) const {Gather(ISet, y);};
+
+    //Split phase transpose, the elements of
+    //a set of x are summed (after Init)
+    void MultTransposeInit() const {yL = 0.0;};
+    void MultTransposeElements(const int ISet, const mfem::Vector & x) const {Scatter(ISet, x);};
+    void MultTransposeBegin() const;
+    void MultTransposeEnd(mfem::Vector & y) const;
+
+    //Overlapped exchanges (else blocking)
+    bool Overlaps() const {return overlap;};
+    const mfem::Array<int> & GetElementSet(const int ISet) const {return elemSets[ISet];};
+
+    //Sizes and offsets
+    UINT GetNElms() const {return nElms;};
+    UINT GetNDofsMax() const {return nDofsMax;};
+    UINT GetElmDofOffset(const UINT IVar) const {return edof_offsets[IVar];};
+    UINT GetTrueDofOffset(const UINT IVar) const {return tdof_offsets[IVar];};
+    UINT GetLocalDofOffset(const UINT IVar) const {return ldof_offsets[IVar];};
+
+    //Get the gather map and signs
+    const mfem::Array<int>    & GetGatherMap() const {return gatherMap;};
+    const mfem::Array<mfem::real_t> & GetGatherSign() const {return gatherSign;};
+
+    //The element colouring (built once),
+    //of a set (-1, every element)
+    const tElementColouring & GetColouring(const int ISet=-1) const;
 };
 
 
@@ -52,52 +151,279 @@ template<typename UINT>
 UINT tRestrictOperator<UINT>::OperatorSizeM(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_)
 {
   UINT EDofs=0;
-  for(UINT I=0; I<ParFEs_.Size(); I++ ) EDofs += ParFEs_[I]->GetVSize();
-  return EDofs;
+  for(UINT I=0; I<ParFEs_.Size(); I++ ){
+    UINT NDofVar=0;
+    for(int J=0; J<ParFEs_[0]->GetNE(); J++){
+      mfem::Array<int> vdofs;
+      ParFEs_[I]->GetElementVDofs(J, vdofs);
+      NDofVar = std::max(UINT(vdofs.Size()), NDofVar);
+    }
+    EDofs += NDofVar;
+  }
+  return EDofs*ParFEs_[0]->GetNE();
 };
 
 template<typename UINT>
 UINT tRestrictOperator<UINT>::OperatorSizeN(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_)
 {
-  UINT TDofs=0; 
-  for(UINT I=0; I<ParFEs_.Size(); I++ ) TDofs += ParFEs_[I]->GlobalTrueVSize();
+  UINT TDofs=0;
+  for(UINT I=0; I<ParFEs_.Size(); I++ ) TDofs += ParFEs_[I]->GetTrueVSize();
   return TDofs;
 };
 
 // The constructor
 template<typename UINT>
-tRestrictOperator<UINT>::tRestrictOperator(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_):
+tRestrictOperator<UINT>::tRestrictOperator(const mfem::Array<mfem::ParFiniteElementSpace*> & ParFEs_, const bool use_dev_):
                                            mfem::Operator(OperatorSizeM(ParFEs_),OperatorSizeN(ParFEs_))
-                                         , row_offsets(ParFEs_.Size()), column_offsets(ParFEs_.Size())
-                                         , ParFEs(ParFEs_)
+                                         , ParFEs(ParFEs_), tdof_offsets(ParFEs_.Size()+1)
+                                         , ldof_offsets(ParFEs_.Size()+1), edof_offsets(ParFEs_.Size()+1)
+                                         , use_dev(use_dev_)
 {
-  for(UINT I=0; I<ParFEs_.Size(); I++ ) row_offsets[I] = ParFEs_[I]->GetVSize();
-  for(UINT I=0; I<ParFEs_.Size(); I++ ) column_offsets[I] = ParFEs_[I]->GlobalTrueVSize();
-  blockRestriction = new mfem::BlockOperator(row_offsets, column_offsets);
+  //The true, local and element
+  //DOF offsets of each Var
+  nElms = ParFEs_[0]->GetNE();
+  tdof_offsets[0]=0; ldof_offsets[0]=0; edof_offsets[0]=0;
+  for(UINT I=0; I<ParFEs_.Size(); I++ ){
+    UINT NDofVar=0;
+    for(UINT J=0; J<nElms; J++){
+      mfem::Array<int> vdofs;
+      ParFEs_[I]->GetElementVDofs(J, vdofs);
+      NDofVar = std::max(UINT(vdofs.Size()), NDofVar);
+    }
+    tdof_offsets[I+1] = tdof_offsets[I] + ParFEs_[I]->GetTrueVSize();
+    ldof_offsets[I+1] = ldof_offsets[I] + ParFEs_[I]->GetVSize();
+    edof_offsets[I+1] = edof_offsets[I] + NDofVar;
+  }
+  nDofsMax = edof_offsets[ParFEs_.Size()];
+  xL.SetSize(ldof_offsets[ParFEs_.Size()]);
+  yL.SetSize(ldof_offsets[ParFEs_.Size()]);
+
+  //Build the gather map, padding
+  //points at local DOF 0 with sign 0
+  gatherMap.SetSize(nDofsMax*nElms);
+  gatherSign.SetSize(nDofsMax*nElms);
+  int *h_map = gatherMap.HostWrite();
+  mfem::real_t *h_sign = gatherSign.HostWrite();
+  for(UINT J=0; J<nElms; J++){
+    for(UINT I=0; I<ParFEs_.Size(); I++ ){
+      mfem::Array<int> vdofs;
+      ParFEs_[I]->GetElementVDofs(J, vdofs);
+      for(UINT K=0; K<(edof_offsets[I+1] - edof_offsets[I]); K++){
+        const UINT Ik = J*nDofsMax + edof_offsets[I] + K;
+        const bool pad = (K >= UINT(vdofs.Size()));
+        const int  vdof = pad? 0:vdofs[K];
+        h_map[Ik]  = ldof_offsets[I] + ((vdof >= 0)? vdof:(-1-vdof));
+        h_sign[Ik] = pad? 0.0:((vdof >= 0)? 1.0:-1.0);
+      }
+    }
+  }
+
+  //Split phase exchanges, only when every
+  //prolongation is the group communicator
+  //one (host, conforming spaces)
+  overlap = not use_dev;
+  for(UINT I=0; I<ParFEs_.Size(); I++){
+    const mfem::Operator *P = ParFEs_[I]->GetProlongationMatrix();
+    overlap = overlap and (dynamic_cast<const mfem::ConformingProlongationOperator*>(P) != NULL);
+  }
+
+  //Owned local DOF's, the shared local
+  //DOF's (the groups of other ranks)
+  //and the first Var of each communicator
+  const UINT nLDofs = ldof_offsets[ParFEs_.Size()];
+  std::vector<char> shared(nLDofs, 0);
+  gcFirst.SetSize(ParFEs_.Size());
   for(UINT I=0; I<ParFEs_.Size(); I++){
-//    ElementRestriction
-  //  blockRestriction->SetBlock(I,I, ParFEs_.Ptr());
+    gcFirst[I] = true;
+    for(UINT J=0; J<I; J++) gcFirst[I] = gcFirst[I] and (ParFEs_[J] != ParFEs_[I]);
+    if(not overlap) continue;
+    for(int J=0; J<ParFEs_[I]->GetVSize(); J++){
+      const int tdof = ParFEs_[I]->GetLocalTDofNumber(J);
+      if(tdof >= 0){ ownL.Append(ldof_offsets[I] + J);  ownT.Append(tdof_offsets[I] + tdof);};
+    }
+    const mfem::Table & groupLDofs = ParFEs_[I]->GroupComm().GroupLDofTable();
+    for(int IGroup=1; IGroup<groupLDofs.Size(); IGroup++){
+      const int *ldofs = groupLDofs.GetRow(IGroup);
+      for(int K=0; K<groupLDofs.RowSize(IGroup); K++) shared[ldof_offsets[I] + ldofs[K]] = 1;
+    }
   }
+
+  //The interior (two halves) and
+  //interface element sets
+  mfem::Array<int> interior;
+  for(UINT J=0; J<nElms; J++){
+    bool face=false;
+    for(UINT K=0; K<nDofsMax; K++) face = face or ((h_sign[J*nDofsMax + K] != 0.0) and shared[h_map[J*nDofsMax + K]]);
+    if(face){ elemSets[INTERFACE].Append(J);} else{ interior.Append(J);};
+  }
+  for(int J=0; J<interior.Size(); J++) elemSets[(2*J < interior.Size())? INTERIOR_A: INTERIOR_B].Append(interior[J]);
 };
 
 
-// The destructor
+// Mult (Apply the restriction operator)
 template<typename UINT>
-tRestrictOperator<UINT>::~tRestrictOperator()
+void tRestrictOperator<UINT>::Mult(const mfem::Vector & x, mfem::Vector & y) const
 {
-  delete blockRestriction;
+  MultBegin(x);
+  MultEnd();
+  Gather(-1, y);
 };
 
-// Mult (Apply the restriction operator)
 template<typename UINT>
-void tRestrictOperator<UINT>::Mult(const mfem::Vector & x, mfem::Vector & y) const
+void tRestrictOperator<UINT>::MultBegin(const mfem::Vector & x) const
 {
- blockRestriction->Mult(x,y);
+  if(not overlap){
+    //Prolongate the true DOF's of each Var
+    for(UINT I=0; I<ParFEs.Size(); I++){
+      mfem::Vector xT_I, xL_I;
+      xT_I.MakeRef(const_cast<mfem::Vector&>(x), tdof_offsets[I], tdof_offsets[I+1]-tdof_offsets[I]);
+      xL_I.MakeRef(xL, ldof_offsets[I], ldof_offsets[I+1]-ldof_offsets[I]);
+      const mfem::Operator *P = ParFEs[I]->GetProlongationMatrix();
+      if(P != NULL){
+        P->Mult(xT_I, xL_I);
+      }else{
+        xL_I = xT_I;
+      }
+    }
+    return;
+  }
+
+  //The owned local DOF's and
+  //post the halo broadcast
+  const int *h_ownL = ownL.HostRead(), *h_ownT = ownT.HostRead();
+  const mfem::real_t *h_x = x.HostRead();
+  mfem::real_t *h_xL = xL.HostReadWrite();
+  for(int K=0; K<ownL.Size(); K++) h_xL[h_ownL[K]] = h_x[h_ownT[K]];
+  for(UINT I=0; I<ParFEs.Size(); I++) if(gcFirst[I]) ParFEs[I]->GroupComm().BcastBegin(h_xL + ldof_offsets[I], 0);
 };
 
-// GetGradient (get the restriction Operator)
 template<typename UINT>
-mfem::Operator & tRestrictOperator<UINT>::GetGradient() const
+void tRestrictOperator<UINT>::MultEnd() const
+{
+  if(not overlap) return;
+  mfem::real_t *h_xL = xL.HostReadWrite();
+  for(UINT I=0; I<ParFEs.Size(); I++){
+    mfem::GroupCommunicator & gc = ParFEs[I]->GroupComm();
+    if(gcFirst[I]){ gc.BcastEnd(h_xL + ldof_offsets[I], 0);} else{ gc.Bcast(h_xL + ldof_offsets[I], 0);};
+  }
+};
+
+// Gather into the element vectors
+template<typename UINT>
+void tRestrictOperator<UINT>::Gather(const int ISet, mfem::Vector & y) const
+{
+  const mfem::Array<int> *elems = ElementSet(ISet);
+  const UINT nD = nDofsMax;
+  const int nE = (elems == NULL)? nElms: elems->Size();
+  const int *d_el = (elems == NULL)? NULL: elems->Read(use_dev);
+  const auto d_map  = gatherMap.Read(use_dev);
+  const auto d_sign = gatherSign.Read(use_dev);
+  const auto d_xL   = xL.Read(use_dev);
+  auto d_y = (elems == NULL)? y.Write(use_dev): y.ReadWrite(use_dev);
+  tForall(use_dev, nD*nE, [=] MFEM_HOST_DEVICE (int Ik)
+  {
+    const int Ie = (d_el == NULL)? Ik: d_el[Ik/nD]*nD + Ik%nD;
+    d_y[Ie] = d_sign[Ie]*d_xL[d_map[Ie]];
+  });
+};
+
+
+// MultTranspose (Apply the transpose restriction operator)
+template<typename UINT>
+void tRestrictOperator<UINT>::MultTranspose(const mfem::Vector & x, mfem::Vector & y) const
+{
+  MultTransposeInit();
+  Scatter(-1, x);
+  MultTransposeBegin();
+  MultTransposeEnd(y);
+};
+
+// Scatter-add the element vectors
+// (elements share local DOF's)
+template<typename UINT>
+void tRestrictOperator<UINT>::Scatter(const int ISet, const mfem::Vector & x) const
+{
+  const mfem::Array<int> *elems = ElementSet(ISet);
+  const UINT nD = nDofsMax;
+  const auto d_map  = gatherMap.Read(use_dev);
+  const auto d_sign = gatherSign.Read(use_dev);
+  const auto d_x    = x.Read(use_dev);
+  auto d_yL = yL.ReadWrite(use_dev);
+  if(use_dev or (tHostThreads::GetNumThreads() <= 1)){
+    const int nE = (elems == NULL)? nElms: elems->Size();
+    const int *d_el = (elems == NULL)? NULL: elems->Read(use_dev);
+    mfem::forall_switch(use_dev, nD*nE, [=] MFEM_HOST_DEVICE (int Ik)
+    {
+      const int Ie = (d_el == NULL)? Ik: d_el[Ik/nD]*nD + Ik%nD;
+      mfem::AtomicAdd(d_yL[d_map[Ie]], d_sign[Ie]*d_x[Ie]);
+    });
+  }else{
+    //The elements of a colour share
+    //no local DOF's
+    const tElementColouring & colours = GetColouring(ISet);
+    for(int IColour=0; IColour<colours.GetNColours(); IColour++){
+      const int *elms = colours.GetElms(IColour);
+      tHostForall(colours.GetNElms(IColour), [=](int Ie)
+      {
+        const UINT Ik0 = elms[Ie]*nD;
+        for(UINT K=0; K<nD; K++) d_yL[d_map[Ik0+K]] += d_sign[Ik0+K]*d_x[Ik0+K];
+      });
+    }
+  }
+};
+
+template<typename UINT>
+void tRestrictOperator<UINT>::MultTransposeBegin() const
+{
+  //Post the reduction of
+  //the shared local DOF's
+  if(not overlap) return;
+  const mfem::real_t *h_yL = yL.HostRead();
+  for(UINT I=0; I<ParFEs.Size(); I++) if(gcFirst[I]) ParFEs[I]->GroupComm().ReduceBegin(h_yL + ldof_offsets[I]);
+};
+
+template<typename UINT>
+void tRestrictOperator<UINT>::MultTransposeEnd(mfem::Vector & y) const
+{
+  if(overlap){
+    //Sum the reduction, the owned local
+    //DOF's are the true DOF's
+    mfem::real_t *h_yL = yL.HostReadWrite();
+    for(UINT I=0; I<ParFEs.Size(); I++){
+      mfem::GroupCommunicator & gc = ParFEs[I]->GroupComm();
+      if(gcFirst[I]){
+        gc.ReduceEnd(h_yL + ldof_offsets[I], 0, mfem::GroupCommunicator::Sum<mfem::real_t>);
+      }else{
+        gc.Reduce(h_yL + ldof_offsets[I], mfem::GroupCommunicator::Sum<mfem::real_t>);
+      }
+    }
+    const int *h_ownL = ownL.HostRead(), *h_ownT = ownT.HostRead();
+    mfem::real_t *h_y = y.HostWrite();
+    for(int K=0; K<ownL.Size(); K++) h_y[h_ownT[K]] = h_yL[h_ownL[K]];
+    return;
+  }
+
+  //Sum the shared local DOF's
+  //into the true DOF's of each Var
+  for(UINT I=0; I<ParFEs.Size(); I++){
+    mfem::Vector yT_I, yL_I;
+    yT_I.MakeRef(y, tdof_offsets[I], tdof_offsets[I+1]-tdof_offsets[I]);
+    yL_I.MakeRef(yL, ldof_offsets[I], ldof_offsets[I+1]-ldof_offsets[I]);
+    const mfem::Operator *P = ParFEs[I]->GetProlongationMatrix();
+    if(P != NULL){
+      P->MultTranspose(yL_I, yT_I);
+    }else{
+      yT_I = yL_I;
+    }
+  }
+};
+
+
+// The element colourings
+template<typename UINT>
+const tElementColouring & tRestrictOperator<UINT>::GetColouring(const int ISet) const
 {
-  return *blockRestriction;
+  if(colourings[ISet+1] == NULL) colourings[ISet+1] = new tElementColouring(gatherMap, gatherSign, nElms, nDofsMax
+                                                                           , ldof_offsets[ParFEs.Size()], ElementSet(ISet));
+  return *colourings[ISet+1];
 };
@@ -0,0 +1,247 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#include "mfem.hpp"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+
+/*****************************************\
+!
+!  Preconditioner with a lagged setup, the
+!  Krylov solvers call SetOperator on their
+!  preconditioner at every SetOperator,
+!  this only (re)builds the factorisation
+!  when the Newton solver asks for it
+!
+\*****************************************/
+class tLaggedPreconditioner : public mfem::Solver
+{
+  private:
+    mfem::Solver & prec;
+    bool rebuild=true;
+
+  public:
+    tLaggedPreconditioner(mfem::Solver & prec_): mfem::Solver(), prec(prec_){};
+
+    //Rebuild at the next SetOperator
+    void Rebuild(){rebuild=true;};
+
+    void SetOperator(const mfem::Operator & op)
+    {
+      height = op.Height();  width = op.Width();
+      if(rebuild) prec.SetOperator(op);
+      rebuild=false;
+    };
+
+    void Mult(const mfem::Vector & x, mfem::Vector & y) const {prec.Mult(x,y);};
+};
+
+
+/*****************************************\
+!
+!  Newton-Krylov solver for the stationary
+!  point of the energy of a form (Form
+!  provides MultAndGradient and GetEnergy):
+!   -The linear tolerance is adaptive
+!    (Eisenstat-Walker, choice 2):
+!     eta_k = gamma.(|r_k|/|r_k-1|)^alpha
+!    safeguarded by gamma.eta_k-1^alpha and
+!    bounded by eta_max
+!   -The step is backtracked on the energy
+!    (Armijo): e(x - a.dx) <= e(x) - c1.a.r.dx
+!    (up to the round-off of e)
+!   -A Krylov solve that does not converge,
+!    a direction that is not a descent
+!    direction or a line search that finds
+!    no decrease is retried once with a
+!    rebuilt preconditioner (if it was
+!    lagged), otherwise the solve fails
+!    (GetConverged() = false, x is the
+!    last accepted iterate)
+!   -The preconditioner is lagged, it is
+!    only rebuilt when the residual
+!    reduction is worse than lag_rate, the
+!    Krylov iterations grow by lag_its or
+!    it is older than lag_max iterations
+!
+\*****************************************/
+template<typename Form>
+class tNewtonSolver
+{
+  private:
+    const Form & form;
+    mfem::IterativeSolver & krylov;
+    tLaggedPreconditioner *prec=NULL;
+    MPI_Comm comm;
+
+    //Newton convergence
+    mfem::real_t rel_tol=1e-8, abs_tol=1e-12;
+    int max_iter=50, print_level=1;
+
+    //Eisenstat-Walker
+    mfem::real_t ew_gamma=0.9, ew_alpha=0.5*(1.0 + std::sqrt(5.0));
+    mfem::real_t eta0=0.5, eta_max=0.9;
+
+    //Energy backtracking
+    mfem::real_t ls_c1=1e-4, ls_factor=0.5;
+    mfem::real_t ls_noise=1e2*std::numeric_limits<mfem::real_t>::epsilon();
+    int ls_max=10;
+
+    //Preconditioner lagging
+    mfem::real_t lag_rate=0.5, lag_its=1.5;
+    int lag_max=10;
+
+    //Solver output
+    mutable int final_iter=0;
+    mutable bool converged=false;
+    mutable mfem::real_t final_norm=0.0;
+    mutable mfem::Vector r, dx, xTrial;
+
+    mfem::real_t Norm(const mfem::Vector & v) const {return std::sqrt(mfem::InnerProduct(comm, v, v));};
+
+  public:
+    //Constructor, the Krylov solver and
+    //its (optional) preconditioner
+    tNewtonSolver(const Form & form_, mfem::IterativeSolver & krylov_, MPI_Comm comm_);
+    tNewtonSolver(const Form & form_, mfem::IterativeSolver & krylov_, mfem::Solver & prec_, MPI_Comm comm_);
+
+    //Destructor
+    ~tNewtonSolver(){delete prec;};
+
+    //Settings
+    void SetRelTol(const mfem::real_t tol){rel_tol = tol;};
+    void SetAbsTol(const mfem::real_t tol){abs_tol = tol;};
+    void SetMaxIter(const int its){max_iter = its;};
+    void SetPrintLevel(const int level){print_level = level;};
+    void SetAdaptiveLinRtol(const mfem::real_t gamma, const mfem::real_t alpha
+                          , const mfem::real_t eta0_=0.5, const mfem::real_t eta_max_=0.9)
+                          {ew_gamma=gamma; ew_alpha=alpha; eta0=eta0_; eta_max=eta_max_;};
+    //(rel_noise, the relative round-off of
+    //the energy, e.g. larger for float forms)
+    void SetLineSearch(const mfem::real_t c1, const mfem::real_t factor=0.5, const int max_trials=10
+                     , const mfem::real_t rel_noise=1e2*std::numeric_limits<mfem::real_t>::epsilon())
+                     {ls_c1=c1; ls_factor=factor; ls_max=max_trials; ls_noise=rel_noise;};
+    void SetLagging(const mfem::real_t rate, const mfem::real_t its_growth=1.5, const int max_age=10)
+                  {lag_rate=rate; lag_its=its_growth; lag_max=max_age;};
+
+    //Solve R(x) = 0 from the initial guess x
+    void Mult(mfem::Vector & x) const;
+
+    //Solver output
+    int GetNumIterations() const {return final_iter;};
+    bool GetConverged() const {return converged;};
+    mfem::real_t GetFinalNorm() const {return final_norm;};
+};
+
+
+/*****************************************\
+!
+!  This implements the tNewtonSolver
+!  class
+!
+\*****************************************/
+template<typename Form>
+tNewtonSolver<Form>::tNewtonSolver(const Form & form_, mfem::IterativeSolver & krylov_, MPI_Comm comm_):
+                                   form(form_), krylov(krylov_), comm(comm_){};
+
+template<typename Form>
+tNewtonSolver<Form>::tNewtonSolver(const Form & form_, mfem::IterativeSolver & krylov_
+                                 , mfem::Solver & prec_, MPI_Comm comm_):
+                                   form(form_), krylov(krylov_), comm(comm_)
+{
+  prec = new tLaggedPreconditioner(prec_);
+  krylov.SetPreconditioner(*prec);
+};
+
+
+template<typename Form>
+void tNewtonSolver<Form>::Mult(mfem::Vector & x) const
+{
+  int myid=0;
+  MPI_Comm_rank(comm, &myid);
+  r.SetSize(x.Size());  dx.SetSize(x.Size());  xTrial.SetSize(x.Size());
+  krylov.iterative_mode = false;
+  krylov.SetAbsTol(0.0);
+  if(prec != NULL) prec->Rebuild();
+
+  mfem::real_t norm0=0.0, normPrev=0.0, eta=eta0;
+  mfem::real_t e = form.GetEnergy(x);
+  int precAge=0, precIts=0;
+  bool itsGrew=false;
+  converged=false;
+  for(int it=0; it<=max_iter; it++){
+    //Residual and Jacobian (one pass)
+    mfem::Operator & J = form.MultAndGradient(x, r);
+    const mfem::real_t norm = Norm(r);
+    if(it == 0) norm0 = norm;
+    const mfem::real_t tol = std::max(rel_tol*norm0, abs_tol);
+    if(print_level > 0 and myid == 0) std::printf("Newton %3d : |r| = %.6e  e = %.12e\n", it, norm, e);
+    final_iter = it;  final_norm = norm;
+    if(norm <= tol){ converged=true; break;};
+    if(it == max_iter) break;
+
+    //Adaptive linear tolerance (bounded
+    //below to not over-solve the last step)
+    if(it > 0){
+      const mfem::real_t etaSafe = ew_gamma*std::pow(eta, ew_alpha);
+      eta = ew_gamma*std::pow(norm/normPrev, ew_alpha);
+      if(etaSafe > 0.1) eta = std::max(eta, etaSafe);
+      eta = std::min(eta, eta_max);
+    }
+    eta = std::max(eta, 0.5*tol/norm);
+
+    //Lag the preconditioner
+    const bool slow = (it > 0) and (norm > lag_rate*normPrev);
+    if((prec != NULL) and (slow or itsGrew or (precAge >= lag_max))){ prec->Rebuild(); precAge=0;};
+
+    //Solve J.dx = r and backtrack on the
+    //energy, retried once with a rebuilt
+    //preconditioner if it was lagged
+    const mfem::real_t eNoise = ls_noise*std::abs(e);
+    mfem::real_t a=1.0, eTrial=e;
+    int linIts=0;
+    const char *failure=NULL;
+    for(int attempt=0; attempt<2; attempt++){
+      if(attempt > 0){
+        if((prec == NULL) or (precAge <= 1)) break;
+        prec->Rebuild();
+        precAge=0;
+      }
+      krylov.SetRelTol(eta);
+      krylov.SetOperator(J);
+      dx = 0.0;
+      krylov.Mult(r, dx);
+      linIts = krylov.GetNumIterations();
+      if(precAge == 0) precIts = linIts;
+      itsGrew = (precAge > 0) and (linIts > lag_its*precIts);
+      precAge++;
+      failure = "the Krylov solver did not converge";
+      if(not krylov.GetConverged()) continue;
+
+      //Backtrack (descent directions only)
+      const mfem::real_t rdx = mfem::InnerProduct(comm, r, dx);
+      failure = "dx is not a descent direction";
+      if(rdx <= 0.0) continue;
+      failure = "the line search found no energy decrease";
+      a=1.0;
+      for(int ls=0; ls<=ls_max; ls++){
+        mfem::add(x, -a, dx, xTrial);
+        eTrial = form.GetEnergy(xTrial);
+        if(eTrial <= e - ls_c1*a*rdx + eNoise){ failure=NULL; break;};
+        a *= ls_factor;
+      }
+      if(failure == NULL) break;
+    }
+
+    //Failed step, x is not updated
+    if(failure != NULL){
+      if(print_level >= 0 and myid == 0) std::printf("Newton %3d : failed, %s\n", it, failure);
+      break;
+    }
+    x = xTrial;
+    e = eTrial;
+    normPrev = norm;
+    if(print_level > 0 and myid == 0) std::printf("           eta = %.3e  Krylov its = %d  step = %.3e\n", eta, linIts, a);
+  }
+};
@@ -0,0 +1,578 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+
+/***************************************\
+!
+!  Hessian-lane (hyper-dual) Numbers
+!
+!  Carries the value, the N first
+!  derivatives and only the upper
+!  triangle of the (symmetric) N x N
+!  second derivatives, packed row by
+!  row:
+!   (0,0) (0,1) .. (0,N-1) (1,1) ..
+!  This replaces the dual-of-dual
+!  evaluation which computes every
+!  (m,n) pair
+!
+\***************************************/
+//Index of the (I,J) (I<=J) entry
+//in the packed upper triangle
+template<unsigned N>
+FORCE_INLINE constexpr unsigned hessIndex(const unsigned I, const unsigned J)
+{
+  return I*N - (I*(I+1))/2 + J;
+};
+
+template<typename value_t, unsigned N>
+struct PACKSTRUCT dualHessNumber{
+  //Definition of the Hessian-lane number
+  static constexpr unsigned nLanes = N;
+  static constexpr unsigned nHess  = (N*(N+1))/2;
+  value_t  val;
+  value_t  grad[N];
+  value_t  hess[(N*(N+1))/2];
+
+  FORCE_INLINE dualHessNumber(value_t r=0.0): val(r){
+    #pragma unroll
+    for(unsigned I=0; I<N; I++) grad[I] = 0.0;
+    #pragma unroll
+    for(unsigned I=0; I<nHess; I++) hess[I] = 0.0;
+  };
+
+  //Seed a single unit lane, i.e.
+  //the input variable number (lane)
+  FORCE_INLINE dualHessNumber(value_t r, unsigned lane): dualHessNumber(r){
+    grad[lane] = 1.0;
+  };
+};
+
+//The primal value of a Hessian-lane number
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr auto primalValue(const dualHessNumber<v_t,N> & a){return primalValue(a.val);};
+
+/***************************************\
+!
+!  Chain rule of a scalar function f
+!  applied to a Hessian-lane number
+!  given f(a), f'(a) and f''(a):
+!   df   = f'.da
+!   d2f  = f'.d2a + f''.da (x) da
+!
+\***************************************/
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> hessChain(const dualHessNumber<v_t,N> & a
+                                                     , const v_t f0, const v_t f1, const v_t f2)
+{
+  dualHessNumber<v_t,N> newVal;
+  newVal.val = f0;
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) newVal.grad[I] = f1*a.grad[I];
+  #pragma unroll
+  for(unsigned I=0; I<N; I++){
+    #pragma unroll
+    for(unsigned J=I; J<N; J++){
+      const unsigned IJ = hessIndex<N>(I,J);
+      newVal.hess[IJ] = f1*a.hess[IJ] + f2*a.grad[I]*a.grad[J];
+    }
+  }
+  return newVal;
+};
+
+/***************************************\
+!
+!  Dual-Dual number
+!  Equivalence/augmentation operations
+!
+\***************************************/
+//Increment operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  a.val = a.val + b.val;
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) a.grad[I] = a.grad[I] + b.grad[I];
+  #pragma unroll
+  for(unsigned I=0; I<a.nHess; I++) a.hess[I] = a.hess[I] + b.hess[I];
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualHessNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val + b;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualHessNumber<v_t,N> & a, const float & b)
+{
+  a.val = a.val + b;
+};
+
+//Decrement operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  a.val = a.val - b.val;
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) a.grad[I] = a.grad[I] - b.grad[I];
+  #pragma unroll
+  for(unsigned I=0; I<a.nHess; I++) a.hess[I] = a.hess[I] - b.hess[I];
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualHessNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val - b;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualHessNumber<v_t,N> & a, const float & b)
+{
+  a.val = a.val - b;
+};
+
+//Multiplication equals operator
+// d2(ab)_IJ = a.d2b_IJ + b.d2a_IJ + da_I.db_J + da_J.db_I
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  #pragma unroll
+  for(unsigned I=0; I<N; I++){
+    #pragma unroll
+    for(unsigned J=I; J<N; J++){
+      const unsigned IJ = hessIndex<N>(I,J);
+      a.hess[IJ] = a.val*b.hess[IJ] + a.hess[IJ]*b.val
+                 + a.grad[I]*b.grad[J] + a.grad[J]*b.grad[I];
+    }
+  }
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) a.grad[I] = a.val*b.grad[I] + a.grad[I]*b.val;
+  a.val = a.val*b.val;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualHessNumber<v_t,N> & a, const double & b)
+{
+  a.val = b*a.val;
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) a.grad[I] = b*a.grad[I];
+  #pragma unroll
+  for(unsigned I=0; I<a.nHess; I++) a.hess[I] = b*a.hess[I];
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualHessNumber<v_t,N> & a, const float & b)
+{
+  a *= double(b);
+};
+
+//Divide equals operator
+// a/b = a*(1/b)
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  v_t invB = 1.0/b.val;
+  a *= hessChain<v_t,N>(b, invB, -invB*invB, 2.0*invB*invB*invB);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualHessNumber<v_t,N> & a, const double & b)
+{
+  a *= (1.0/b);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualHessNumber<v_t,N> & a, const float & b)
+{
+  a *= (1.0/double(b));
+};
+
+/***************************************\
+!
+!  Dual-Dual number operations
+!
+\***************************************/
+//Multiplication operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  dualHessNumber<v_t,N> newVal(a);
+  newVal *= b;
+  return newVal;
+};
+
+//Division operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  dualHessNumber<v_t,N> newVal(a);
+  newVal /= b;
+  return newVal;
+};
+
+//Addition operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  dualHessNumber<v_t,N> newVal(a);
+  newVal += b;
+  return newVal;
+};
+
+//Subtraction operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  dualHessNumber<v_t,N> newVal(a);
+  newVal -= b;
+  return newVal;
+};
+
+//Negation operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const dualHessNumber<v_t,N> & a)
+{
+  dualHessNumber<v_t,N> newVal(a);
+  newVal *= -1.0;
+  return newVal;
+};
+
+/***************************************\
+!
+!  Dual number comparison operations
+!  (only the primal value is compared)
+!
+\***************************************/
+//equivalence operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator==(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return (a.val == b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator==(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return (a.val == b);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator==(const Number b, const dualHessNumber<v_t,N> & a)
+{
+  return (a.val == b);
+};
+
+
+//inequivalence operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator!=(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return (a.val != b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator!=(const Number a, const dualHessNumber<v_t,N> & b)
+{
+  return (a != b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator!=(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return (a.val != b);
+};
+
+
+//more than operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator>(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return a.val > b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>(const Number a, const dualHessNumber<v_t,N> & b)
+{
+  return a > b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return a.val > b;
+};
+
+
+//less than operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator<(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return a.val < b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<(const Number a, const dualHessNumber<v_t,N> & b)
+{
+  return a < b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return a.val < b;
+};
+
+
+//more than equal operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator>=(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return a.val >= b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>=(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return a.val >= b;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>=(const Number a, const dualHessNumber<v_t,N> & b)
+{
+  return a >= b.val;
+};
+
+
+//less than equal operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator<=(const dualHessNumber<v_t,N> & a, const dualHessNumber<v_t,N> & b)
+{
+  return a.val <= b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<=(const dualHessNumber<v_t,N> & a, const Number b)
+{
+  return a.val <= b;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<=(const Number a, const dualHessNumber<v_t,N> & b)
+{
+  return a <= b.val;
+};
+
+
+/***************************************\
+!
+!  Number-Dual number operations
+!
+\***************************************/
+///////////
+//Multiplication operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const dualHessNumber<v_t,N> & dNum, const double Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal *= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const dualHessNumber<v_t,N> & dNum, const float Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal *= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const double Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return dNum*Num;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const float Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return dNum*Num;
+};
+
+///////////
+//Division operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const dualHessNumber<v_t,N> & dNum, const double Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal /= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const dualHessNumber<v_t,N> & dNum, const float Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal /= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const double Num, const dualHessNumber<v_t,N> & dNum)
+{
+  v_t invB = 1.0/dNum.val;
+  return hessChain<v_t,N>(dNum, Num*invB, -Num*invB*invB, 2.0*Num*invB*invB*invB);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const float Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return double(Num)/dNum;
+};
+
+///////////
+//Addition operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const dualHessNumber<v_t,N> & dNum, const double Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal += Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const dualHessNumber<v_t,N> & dNum, const float Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal += Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const double Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return dNum + Num;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const float Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return dNum + Num;
+};
+
+///////////
+//Subtraction operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const dualHessNumber<v_t,N> & dNum, const double Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal -= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const dualHessNumber<v_t,N> & dNum, const float Num)
+{
+  dualHessNumber<v_t,N> newVal(dNum);
+  newVal -= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const double Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return -(dNum - Num);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const float Num, const dualHessNumber<v_t,N> & dNum)
+{
+  return -(dNum - Num);
+};
+
+
+/***************************************\
+!
+!  Integer-Dual number operations, the
+!  integral scalars (2*x, x/3, 1 - x)
+!  promote to double (otherwise the
+!  double and float overloads are
+!  ambiguous)
+!
+\***************************************/
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator+=(dualHessNumber<v_t,N> & a, const Int b){a += double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator-=(dualHessNumber<v_t,N> & a, const Int b){a -= double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator*=(dualHessNumber<v_t,N> & a, const Int b){a *= double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator/=(dualHessNumber<v_t,N> & a, const Int b){a /= double(b);};
+
+//Multiplication operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const dualHessNumber<v_t,N> & dNum, const Int Num){return dNum*double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator*(const Int Num, const dualHessNumber<v_t,N> & dNum){return dNum*double(Num);};
+
+//Division operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const dualHessNumber<v_t,N> & dNum, const Int Num){return dNum/double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator/(const Int Num, const dualHessNumber<v_t,N> & dNum){return double(Num)/dNum;};
+
+//Addition operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const dualHessNumber<v_t,N> & dNum, const Int Num){return dNum + double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator+(const Int Num, const dualHessNumber<v_t,N> & dNum){return dNum + double(Num);};
+
+//Subtraction operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const dualHessNumber<v_t,N> & dNum, const Int Num){return dNum - double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualHessNumber<v_t,N> operator-(const Int Num, const dualHessNumber<v_t,N> & dNum){return double(Num) - dNum;};
+
+
+/***************************************\
+!
+!  Evaluate the gradient and Hessian of
+!  a scalar functional of N inputs with
+!  a single evaluation, F must be
+!  callable as F(const dualHessNumber*)
+!  the Hessian is written out in full
+!  (N x N, symmetric so the row/column
+!  major ordering does not matter, e.g.
+!  DenseMatrix::Data()) and the value
+!  of F is returned
+!
+\***************************************/
+template<unsigned N, typename Number, typename Functional>
+FORCE_INLINE Number tHessian(const Functional & F, const Number x[], Number dFdx[], Number d2Fdx2[])
+{
+  dualHessNumber<Number,N> xHess[N];
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) xHess[I] = dualHessNumber<Number,N>(x[I],I);
+
+  dualHessNumber<Number,N> FHess = F(xHess);
+  #pragma unroll
+  for(unsigned I=0; I<N; I++){
+    dFdx[I] = FHess.grad[I];
+    #pragma unroll
+    for(unsigned J=I; J<N; J++){
+      d2Fdx2[I*N + J] = FHess.hess[hessIndex<N>(I,J)];
+      d2Fdx2[J*N + I] = FHess.hess[hessIndex<N>(I,J)];
+    }
+  }
+  return FHess.val;
+};
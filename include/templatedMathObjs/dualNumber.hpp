@@ -5,6 +5,17 @@
 !
 !  Dual-Numbers
 !
+!  The operators evaluate eagerly (no
+!  expression templates): the value and
+!  the gradient are one scalar each, so
+!  there are no lanes to fuse. Nested
+!  duals whose members are dualVecNumbers
+!  fuse each member expression (e.g.
+!  a.val*b.grad + a.grad*b.val) through
+!  the dualVecNumber expression templates
+!  (see dualVecNumber.hpp), the wide
+!  gradients are only carried there
+!
 \***************************************/
 template<typename value_t, typename gradient_t>
 struct PACKSTRUCT dualNumber{
@@ -15,6 +26,10 @@ struct PACKSTRUCT dualNumber{
   FORCE_INLINE dualNumber(value_t r=0.0, gradient_t eps=0.0): val(r), grad(eps){};
 };
 
+//The primal value of a (nested) dual number
+template<typename v_t, typename g_t>
+FORCE_INLINE constexpr auto primalValue(const dualNumber<v_t,g_t> & a){return primalValue(a.val);};
+
 /***************************************\
 !
 !  Dual-Dual number
@@ -87,7 +102,7 @@ FORCE_INLINE constexpr void operator*=(dualNumber<v_t,g_t> & a, const float & b)
 template<typename v_t, typename g_t>
 FORCE_INLINE constexpr void operator/=(dualNumber<v_t,g_t> & a, const dualNumber<v_t,g_t> & b) 
 {
-  a.grad = (a.grad*b.val + a.val*b.grad)/(b.val*b.val);
+  a.grad = (a.grad*b.val - a.val*b.grad)/(b.val*b.val);
   a.val  = (a.val/b.val);
 };
 
@@ -112,7 +127,7 @@ FORCE_INLINE constexpr void operator/=(dualNumber<v_t,g_t> & a, const float & b)
 \***************************************/
 //Multiplication operator
 template<typename v_t, typename g_t>
-FORCE_INLINE constexpr dualNumber<v_t,g_t> operator*(const dualNumber<v_t,g_t> a, const dualNumber<v_t,g_t> b) 
+FORCE_INLINE constexpr dualNumber<v_t,g_t> operator*(const dualNumber<v_t,g_t> & a, const dualNumber<v_t,g_t> & b) 
 {
   dualNumber<v_t,g_t> newVal;
   newVal.val  = a.val*b.val;
@@ -122,17 +137,17 @@ FORCE_INLINE constexpr dualNumber<v_t,g_t> operator*(const dualNumber<v_t,g_t> a
 
 //Division operator
 template<typename v_t, typename g_t>
-FORCE_INLINE constexpr dualNumber<v_t,g_t> operator/(const dualNumber<v_t,g_t> a, const dualNumber<v_t,g_t> b) 
+FORCE_INLINE constexpr dualNumber<v_t,g_t> operator/(const dualNumber<v_t,g_t> & a, const dualNumber<v_t,g_t> & b) 
 {
   dualNumber<v_t, g_t> newVal;
   newVal.val  = (a.val/b.val);
-  newVal.grad = (a.grad*b.val + a.val*b.grad)/(b.val*b.val);
+  newVal.grad = (a.grad*b.val - a.val*b.grad)/(b.val*b.val);
   return newVal;
 };
 
 //Addition operator
 template<typename v_t, typename g_t>
-FORCE_INLINE constexpr dualNumber<v_t,g_t> operator+(const dualNumber<v_t,g_t> a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr dualNumber<v_t,g_t> operator+(const dualNumber<v_t,g_t> & a, const dualNumber<v_t,g_t> & b)
 {
   dualNumber<v_t, g_t> newVal;
   newVal.val  = a.val + b.val;
@@ -142,7 +157,7 @@ FORCE_INLINE constexpr dualNumber<v_t,g_t> operator+(const dualNumber<v_t,g_t> a
 
 //Subtraction operator
 template<typename v_t, typename g_t>
-FORCE_INLINE constexpr dualNumber<v_t,g_t> operator-(const dualNumber<v_t,g_t> a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr dualNumber<v_t,g_t> operator-(const dualNumber<v_t,g_t> & a, const dualNumber<v_t,g_t> & b)
 {
   dualNumber<v_t, g_t> newVal;
   newVal.val  = a.val - b.val;
@@ -150,6 +165,16 @@ FORCE_INLINE constexpr dualNumber<v_t,g_t> operator-(const dualNumber<v_t,g_t> a
   return newVal;
 };
 
+//Negation operator
+template<typename v_t, typename g_t>
+FORCE_INLINE constexpr dualNumber<v_t,g_t> operator-(const dualNumber<v_t,g_t> & a)
+{
+  dualNumber<v_t, g_t> newVal;
+  newVal.val  = -1.0*a.val;
+  newVal.grad = -1.0*a.grad;
+  return newVal;
+};
+
 /***************************************\
 !
 !  Dual number comparison operations
@@ -157,13 +182,13 @@ FORCE_INLINE constexpr dualNumber<v_t,g_t> operator-(const dualNumber<v_t,g_t> a
 \***************************************/
 //equivalence operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator==(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator==(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return (a.val == b);
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator==(const Number b, const dualNumber<v_t,g_t> a)
+FORCE_INLINE constexpr bool operator==(const Number b, const dualNumber<v_t,g_t> & a)
 {
   return (a.val == b);
 };
@@ -171,13 +196,13 @@ FORCE_INLINE constexpr bool operator==(const Number b, const dualNumber<v_t,g_t>
 
 //inequivalence operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator!=(const Number a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr bool operator!=(const Number a, const dualNumber<v_t,g_t> & b)
 {
   return (a != b.val);
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator!=(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator!=(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return (a.val != b);
 };
@@ -185,13 +210,13 @@ FORCE_INLINE constexpr bool operator!=(const dualNumber<v_t,g_t> a, const Number
 
 //more than operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator>(const  Number a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr bool operator>(const  Number a, const dualNumber<v_t,g_t> & b)
 {
   return a > b.val;
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator>(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator>(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return a.val > b;
 }
@@ -199,13 +224,13 @@ FORCE_INLINE constexpr bool operator>(const dualNumber<v_t,g_t> a, const Number
 
 //less than operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator<(const Number a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr bool operator<(const Number a, const dualNumber<v_t,g_t> & b)
 {
   return a < b.val;
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator<(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator<(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return a.val < b;
 };
@@ -213,13 +238,13 @@ FORCE_INLINE constexpr bool operator<(const dualNumber<v_t,g_t> a, const Number
 
 //more than equal operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator>=(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator>=(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return a.val >= b;
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator>=(const Number a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr bool operator>=(const Number a, const dualNumber<v_t,g_t> & b)
 {
   return a >= b.val;
 };
@@ -227,13 +252,13 @@ FORCE_INLINE constexpr bool operator>=(const Number a, const dualNumber<v_t,g_t>
 
 //less than equal operator
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator<=(const dualNumber<v_t,g_t> a, const Number b)
+FORCE_INLINE constexpr bool operator<=(const dualNumber<v_t,g_t> & a, const Number b)
 {
   return a.val <= b;
 };
 
 template<typename v_t, typename g_t, typename Number>
-FORCE_INLINE constexpr bool operator<=(const Number a, const dualNumber<v_t,g_t> b)
+FORCE_INLINE constexpr bool operator<=(const Number a, const dualNumber<v_t,g_t> & b)
 {
   return a <= b.val;
 };
@@ -248,7 +273,7 @@ FORCE_INLINE constexpr bool operator<=(const Number a, const dualNumber<v_t,g_t>
 //Multiplication operator
 ///////////
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t,grad_t> dNum, const double Num) 
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t,grad_t> & dNum, const double Num) 
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = Num*dNum.val;
@@ -257,7 +282,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t,grad_t> dNum, const float Num) 
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t,grad_t> & dNum, const float Num) 
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = Num*dNum.val;
@@ -266,7 +291,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t, typename Number>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const Number Num, const dualNumber<val_t,grad_t> dNum) 
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const Number Num, const dualNumber<val_t,grad_t> & dNum) 
 {
   return dNum*Num;
 };
@@ -275,34 +300,37 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator*(const Number Num, cons
 //Division operator
 ///////////
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const dualNumber<val_t,grad_t> dNum, const double Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const dualNumber<val_t,grad_t> & dNum, const double Num)
 {
   dualNumber<val_t,grad_t> newVal;
-  newVal.val  = newVal.val/Num;
-  newVal.grad = newVal.grad/Num;
+  newVal.val  = dNum.val/Num;
+  newVal.grad = dNum.grad/Num;
   return newVal;
 };
 
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const dualNumber<val_t,grad_t> dNum, const float Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const dualNumber<val_t,grad_t> & dNum, const float Num)
 {
-   dualNumber<val_t,grad_t> newVal;
-  newVal.val  = newVal.val/Num;
-  newVal.grad = newVal.grad/Num;
+  dualNumber<val_t,grad_t> newVal;
+  newVal.val  = dNum.val/Num;
+  newVal.grad = dNum.grad/Num;
   return newVal;
 };
 
 template<typename val_t, typename grad_t, typename Number>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const Number Num, const dualNumber<val_t,grad_t> dNum)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator/(const Number Num, const dualNumber<val_t,grad_t> & dNum)
 {
-  return Num/dNum;
+  dualNumber<val_t,grad_t> newVal;
+  newVal.val  = Num/dNum.val;
+  newVal.grad = (-1.0*newVal.val/dNum.val)*dNum.grad;
+  return newVal;
 };
 
 ///////////
 //Addition operator
 ///////////
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t,grad_t> dNum, const double Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t,grad_t> & dNum, const double Num)
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = dNum.val  + Num;
@@ -311,7 +339,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t,grad_t> dNum, const float Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t,grad_t> & dNum, const float Num)
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = dNum.val  + Num;
@@ -320,7 +348,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t, typename Number>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const Number Num, const dualNumber<val_t,grad_t> dNum)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const Number Num, const dualNumber<val_t,grad_t> & dNum)
 {
   return dNum + Num;
 };
@@ -329,7 +357,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator+(const Number Num, cons
 //Subtraction operator
 ///////////
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t,grad_t> dNum, const double Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t,grad_t> & dNum, const double Num)
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = dNum.val  - Num;
@@ -338,7 +366,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t,grad_t> dNum, const float Num)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t,grad_t> & dNum, const float Num)
 {
   dualNumber<val_t,grad_t> newVal;
   newVal.val  = dNum.val  - Num;
@@ -347,7 +375,7 @@ FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const dualNumber<val_t
 };
 
 template<typename val_t, typename grad_t, typename Number>
-FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const Number Num, const dualNumber<val_t,grad_t> dNum)
+FORCE_INLINE constexpr dualNumber<val_t,grad_t> operator-(const Number Num, const dualNumber<val_t,grad_t> & dNum)
 {
   return -1.0*(dNum - Num);
 };
@@ -0,0 +1,497 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#include "simdLanes.hpp"
+
+/***************************************\
+!
+!  SIMD packed vector-mode Dual-Numbers
+!
+!  Same as the dualVecNumber but the
+!  gradient lanes are stored aligned and
+!  padded to a whole number of SIMD
+!  registers (padding lanes stay zero)
+!  and are propagated with the packed
+!  lane kernels (AVX2/AVX-512 or the
+!  scalar fallback). The struct is not
+!  packed so the alignment is kept
+!
+\***************************************/
+template<typename value_t, unsigned N>
+struct dualSimdNumber{
+  //Definition of the packed dual number
+  static constexpr unsigned nLanes = N;
+  static constexpr unsigned nPad   = simdPaddedLanes<value_t,N>();
+  value_t  val;
+  alignas(SIMD_BYTES) value_t grad[nPad];
+
+  FORCE_INLINE dualSimdNumber(value_t r=0.0): val(r){
+    #pragma unroll
+    for(unsigned I=0; I<nPad; I++) grad[I] = 0.0;
+  };
+
+  //Seed a single unit lane, i.e.
+  //the input variable number (lane)
+  FORCE_INLINE dualSimdNumber(value_t r, unsigned lane): val(r){
+    #pragma unroll
+    for(unsigned I=0; I<nPad; I++) grad[I] = ((I==lane)? 1.0:0.0);
+  };
+};
+
+//The lane kernels for a packed dual
+template<typename v_t, unsigned N>
+using dualSimdLanes = laneOps<v_t, dualSimdNumber<v_t,N>::nPad>;
+
+//The primal value of a packed dual number
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr auto primalValue(const dualSimdNumber<v_t,N> & a){return primalValue(a.val);};
+
+/***************************************\
+!
+!  Dual-Dual number
+!  Equivalence/augmentation operations
+!
+\***************************************/
+//Increment operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  a.val = a.val + b.val;
+  dualSimdLanes<v_t,N>::add(a.grad, a.grad, b.grad);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualSimdNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val + b;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator+=(dualSimdNumber<v_t,N> & a, const float & b)
+{
+  a.val = a.val + b;
+};
+
+//Decrement operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  a.val = a.val - b.val;
+  dualSimdLanes<v_t,N>::sub(a.grad, a.grad, b.grad);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualSimdNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val - b;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator-=(dualSimdNumber<v_t,N> & a, const float & b)
+{
+  a.val = a.val - b;
+};
+
+//Multiplication equals operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  dualSimdLanes<v_t,N>::axpby(a.grad, a.val, b.grad, b.val, a.grad);
+  a.val = a.val*b.val;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualSimdNumber<v_t,N> & a, const double & b)
+{
+  a.val = b*a.val;
+  dualSimdLanes<v_t,N>::scale(a.grad, v_t(b), a.grad);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator*=(dualSimdNumber<v_t,N> & a, const float & b)
+{
+  a.val = b*a.val;
+  dualSimdLanes<v_t,N>::scale(a.grad, v_t(b), a.grad);
+};
+
+//Divide equals operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  v_t invB = 1.0/b.val;
+  v_t aDivB = a.val*invB;
+  dualSimdLanes<v_t,N>::axpby(a.grad, invB, a.grad, -aDivB*invB, b.grad);
+  a.val = aDivB;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualSimdNumber<v_t,N> & a, const double & b)
+{
+  dualSimdLanes<v_t,N>::scale(a.grad, v_t(1.0/b), a.grad);
+  a.val = a.val/b;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr void operator/=(dualSimdNumber<v_t,N> & a, const float & b)
+{
+  dualSimdLanes<v_t,N>::scale(a.grad, v_t(1.0/b), a.grad);
+  a.val = a.val/b;
+};
+
+/***************************************\
+!
+!  Dual-Dual number operations
+!
+\***************************************/
+//Multiplication operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  dualSimdNumber<v_t,N> newVal(a);
+  newVal *= b;
+  return newVal;
+};
+
+//Division operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  dualSimdNumber<v_t,N> newVal(a);
+  newVal /= b;
+  return newVal;
+};
+
+//Addition operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  dualSimdNumber<v_t,N> newVal(a);
+  newVal += b;
+  return newVal;
+};
+
+//Subtraction operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  dualSimdNumber<v_t,N> newVal(a);
+  newVal -= b;
+  return newVal;
+};
+
+//Negation operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const dualSimdNumber<v_t,N> & a)
+{
+  dualSimdNumber<v_t,N> newVal(a);
+  newVal *= -1.0;
+  return newVal;
+};
+
+/***************************************\
+!
+!  Dual number comparison operations
+!  (only the primal value is compared)
+!
+\***************************************/
+//equivalence operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator==(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return (a.val == b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator==(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return (a.val == b);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator==(const Number b, const dualSimdNumber<v_t,N> & a)
+{
+  return (a.val == b);
+};
+
+
+//inequivalence operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator!=(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return (a.val != b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator!=(const Number a, const dualSimdNumber<v_t,N> & b)
+{
+  return (a != b.val);
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator!=(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return (a.val != b);
+};
+
+
+//more than operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator>(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return a.val > b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>(const Number a, const dualSimdNumber<v_t,N> & b)
+{
+  return a > b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return a.val > b;
+};
+
+
+//less than operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator<(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return a.val < b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<(const Number a, const dualSimdNumber<v_t,N> & b)
+{
+  return a < b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return a.val < b;
+};
+
+
+//more than equal operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator>=(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return a.val >= b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>=(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return a.val >= b;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator>=(const Number a, const dualSimdNumber<v_t,N> & b)
+{
+  return a >= b.val;
+};
+
+
+//less than equal operator
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr bool operator<=(const dualSimdNumber<v_t,N> & a, const dualSimdNumber<v_t,N> & b)
+{
+  return a.val <= b.val;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<=(const dualSimdNumber<v_t,N> & a, const Number b)
+{
+  return a.val <= b;
+};
+
+template<typename v_t, unsigned N, typename Number>
+FORCE_INLINE constexpr bool operator<=(const Number a, const dualSimdNumber<v_t,N> & b)
+{
+  return a <= b.val;
+};
+
+
+/***************************************\
+!
+!  Number-Dual number operations
+!
+\***************************************/
+///////////
+//Multiplication operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const dualSimdNumber<v_t,N> & dNum, const double Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal *= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const dualSimdNumber<v_t,N> & dNum, const float Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal *= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const double Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return dNum*Num;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const float Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return dNum*Num;
+};
+
+///////////
+//Division operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const dualSimdNumber<v_t,N> & dNum, const double Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal /= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const dualSimdNumber<v_t,N> & dNum, const float Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal /= Num;
+  return newVal;
+};
+
+// d(c/b) = -c.db/b^2
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const double Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  dualSimdNumber<v_t,N> newVal;
+  newVal.val = Num/dNum.val;
+  dualSimdLanes<v_t,N>::scale(newVal.grad, -newVal.val/dNum.val, dNum.grad);
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const float Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return double(Num)/dNum;
+};
+
+///////////
+//Addition operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const dualSimdNumber<v_t,N> & dNum, const double Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal += Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const dualSimdNumber<v_t,N> & dNum, const float Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal += Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const double Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return dNum + Num;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const float Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return dNum + Num;
+};
+
+///////////
+//Subtraction operator
+///////////
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const dualSimdNumber<v_t,N> & dNum, const double Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal -= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const dualSimdNumber<v_t,N> & dNum, const float Num)
+{
+  dualSimdNumber<v_t,N> newVal(dNum);
+  newVal -= Num;
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const double Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return -(dNum - Num);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const float Num, const dualSimdNumber<v_t,N> & dNum)
+{
+  return -(dNum - Num);
+};
+
+
+/***************************************\
+!
+!  Integer-Dual number operations, the
+!  integral scalars (2*x, x/3, 1 - x)
+!  promote to double (otherwise the
+!  double and float overloads are
+!  ambiguous)
+!
+\***************************************/
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator+=(dualSimdNumber<v_t,N> & a, const Int b){a += double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator-=(dualSimdNumber<v_t,N> & a, const Int b){a -= double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator*=(dualSimdNumber<v_t,N> & a, const Int b){a *= double(b);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr void operator/=(dualSimdNumber<v_t,N> & a, const Int b){a /= double(b);};
+
+//Multiplication operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const dualSimdNumber<v_t,N> & dNum, const Int Num){return dNum*double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator*(const Int Num, const dualSimdNumber<v_t,N> & dNum){return dNum*double(Num);};
+
+//Division operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const dualSimdNumber<v_t,N> & dNum, const Int Num){return dNum/double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator/(const Int Num, const dualSimdNumber<v_t,N> & dNum){return double(Num)/dNum;};
+
+//Addition operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const dualSimdNumber<v_t,N> & dNum, const Int Num){return dNum + double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator+(const Int Num, const dualSimdNumber<v_t,N> & dNum){return dNum + double(Num);};
+
+//Subtraction operator
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const dualSimdNumber<v_t,N> & dNum, const Int Num){return dNum - double(Num);};
+
+template<typename v_t, unsigned N, typename Int, typename = tIntegralArg<Int>>
+FORCE_INLINE constexpr dualSimdNumber<v_t,N> operator-(const Int Num, const dualSimdNumber<v_t,N> & dNum){return double(Num) - dNum;};
@@ -0,0 +1,465 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+
+/***************************************\
+!
+!  Vector-mode Dual-Numbers
+!  (N compile-time gradient lanes)
+!
+!  Each lane carries the derivative
+!  with regards to one input, so a
+!  single evaluation of a functional
+!  returns its full gradient.
+!
+!  The arithmetic is built with
+!  expression templates: an operator
+!  returns a light-weight node (the
+!  value is computed straight away but
+!  the lanes are not), the lanes of a
+!  whole expression such as a*b + c/d
+!  are then evaluated in a single loop
+!  when it is assigned to a
+!  dualVecNumber, with no intermediate
+!  dual numbers.
+!
+!  Note: nodes hold references to the
+!  dualVecNumbers they use, functionals
+!  must return a concrete Number (not
+!  auto) for the same reason as any
+!  other expression template library
+!
+!  Scope: only the vector-mode lanes are
+!  fused, dualNumber, dualSimdNumber
+!  (packed lane kernels), dualHessNumber
+!  and tapeNumber evaluate eagerly, a
+!  dualNumber of dualVecNumbers fuses
+!  each of its members here
+!
+\***************************************/
+//Base of every dual expression (CRTP)
+template<typename E>
+struct dualVecExpr{
+  FORCE_INLINE const E & self() const {return static_cast<const E &>(*this);};
+};
+
+template<typename value_t, unsigned N>
+struct PACKSTRUCT dualVecNumber : public dualVecExpr<dualVecNumber<value_t,N>>{
+  //Definition of the vector dual number
+  using dual_t  = dualVecNumber<value_t,N>;
+  using value_type = value_t;
+  static constexpr unsigned nLanes = N;
+  value_t  val;
+  value_t  grad[N];
+
+  FORCE_INLINE dualVecNumber(value_t r=0.0): val(r){
+    #pragma unroll
+    for(unsigned I=0; I<N; I++) grad[I] = 0.0;
+  };
+
+  //Seed a single unit lane, i.e.
+  //the input variable number (lane)
+  FORCE_INLINE dualVecNumber(value_t r, unsigned lane): val(r){
+    #pragma unroll
+    for(unsigned I=0; I<N; I++) grad[I] = ((I==lane)? 1.0:0.0);
+  };
+
+  //Evaluate an expression, in a single
+  //loop over the lanes
+  template<typename E>
+  FORCE_INLINE dualVecNumber(const dualVecExpr<E> & e): val(e.self().val){
+    #pragma unroll
+    for(unsigned I=0; I<N; I++) grad[I] = e.self().lane(I);
+  };
+
+  //Lane I of every expression only
+  //depends on lane I of its leaves, so
+  //assigning an expression that uses
+  //this number is safe (value last)
+  template<typename E>
+  FORCE_INLINE dualVecNumber & operator=(const dualVecExpr<E> & e){
+    const value_t eVal = e.self().val;
+    #pragma unroll
+    for(unsigned I=0; I<N; I++) grad[I] = e.self().lane(I);
+    val = eVal;
+    return *this;
+  };
+
+  FORCE_INLINE value_t lane(const unsigned I) const {return grad[I];};
+};
+
+//The primal value of a vector dual number
+template<typename v_t, unsigned N>
+FORCE_INLINE constexpr auto primalValue(const dualVecNumber<v_t,N> & a){return primalValue(a.val);};
+
+/***************************************\
+!
+!  Expression nodes, dualVecNumbers are
+!  held by reference and other nodes by
+!  value
+!
+\***************************************/
+template<typename E>
+struct dualVecOperand{using type = const E;};
+
+template<typename v_t, unsigned N>
+struct dualVecOperand<dualVecNumber<v_t,N>>{using type = const dualVecNumber<v_t,N> &;};
+
+//a + b (sgn=1) and a - b (sgn=-1)
+template<typename A, typename B, int sgn>
+struct dualVecSum : public dualVecExpr<dualVecSum<A,B,sgn>>{
+  using dual_t     = typename A::dual_t;
+  using value_type = typename A::value_type;
+  typename dualVecOperand<A>::type a;
+  typename dualVecOperand<B>::type b;
+  value_type val;
+
+  FORCE_INLINE dualVecSum(const A & a_, const B & b_): a(a_), b(b_)
+                                                     , val((sgn > 0)? a_.val + b_.val:a_.val - b_.val){};
+  FORCE_INLINE value_type lane(const unsigned I) const {
+    return (sgn > 0)? a.lane(I) + b.lane(I):a.lane(I) - b.lane(I);
+  };
+};
+
+//a*b
+template<typename A, typename B>
+struct dualVecProd : public dualVecExpr<dualVecProd<A,B>>{
+  using dual_t     = typename A::dual_t;
+  using value_type = typename A::value_type;
+  typename dualVecOperand<A>::type a;
+  typename dualVecOperand<B>::type b;
+  value_type val;
+
+  FORCE_INLINE dualVecProd(const A & a_, const B & b_): a(a_), b(b_), val(a_.val*b_.val){};
+  FORCE_INLINE value_type lane(const unsigned I) const {return a.val*b.lane(I) + a.lane(I)*b.val;};
+};
+
+//a/b
+template<typename A, typename B>
+struct dualVecQuot : public dualVecExpr<dualVecQuot<A,B>>{
+  using dual_t     = typename A::dual_t;
+  using value_type = typename A::value_type;
+  typename dualVecOperand<A>::type a;
+  typename dualVecOperand<B>::type b;
+  value_type invB, val;
+
+  FORCE_INLINE dualVecQuot(const A & a_, const B & b_): a(a_), b(b_)
+                                                      , invB(1.0/b_.val), val(a_.val*invB){};
+  FORCE_INLINE value_type lane(const unsigned I) const {return (a.lane(I) - val*b.lane(I))*invB;};
+};
+
+//s*a + c (scalar s and c)
+template<typename A>
+struct dualVecAffine : public dualVecExpr<dualVecAffine<A>>{
+  using dual_t     = typename A::dual_t;
+  using value_type = typename A::value_type;
+  typename dualVecOperand<A>::type a;
+  value_type s, val;
+
+  FORCE_INLINE dualVecAffine(const A & a_, const double s_, const double c_): a(a_), s(s_)
+                                                                           , val(s_*a_.val + c_){};
+  FORCE_INLINE value_type lane(const unsigned I) const {return s*a.lane(I);};
+};
+
+//c/a (scalar c)
+template<typename A>
+struct dualVecRecip : public dualVecExpr<dualVecRecip<A>>{
+  using dual_t     = typename A::dual_t;
+  using value_type = typename A::value_type;
+  typename dualVecOperand<A>::type a;
+  value_type val, dVal;
+
+  FORCE_INLINE dualVecRecip(const A & a_, const double c_): a(a_), val(c_/a_.val), dVal(-val/a_.val){};
+  FORCE_INLINE value_type lane(const unsigned I) const {return dVal*a.lane(I);};
+};
+
+//Nodes are unevaluated numbers and are
+//kept out of the generic templated maths
+template<typename A, typename B, int sgn> struct isExprNumber<dualVecSum<A,B,sgn>>{static constexpr bool value=true;};
+template<typename A, typename B> struct isExprNumber<dualVecProd<A,B>>{static constexpr bool value=true;};
+template<typename A, typename B> struct isExprNumber<dualVecQuot<A,B>>{static constexpr bool value=true;};
+template<typename A> struct isExprNumber<dualVecAffine<A>>{static constexpr bool value=true;};
+template<typename A> struct isExprNumber<dualVecRecip<A>>{static constexpr bool value=true;};
+
+/***************************************\
+!
+!  Dual-Dual number
+!  Equivalence/augmentation operations
+!
+\***************************************/
+//Increment operator
+template<typename v_t, unsigned N, typename E>
+FORCE_INLINE void operator+=(dualVecNumber<v_t,N> & a, const dualVecExpr<E> & b)
+{
+  a = dualVecSum<dualVecNumber<v_t,N>,E,1>(a, b.self());
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE void operator+=(dualVecNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val + b;
+};
+
+//Decrement operator
+template<typename v_t, unsigned N, typename E>
+FORCE_INLINE void operator-=(dualVecNumber<v_t,N> & a, const dualVecExpr<E> & b)
+{
+  a = dualVecSum<dualVecNumber<v_t,N>,E,-1>(a, b.self());
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE void operator-=(dualVecNumber<v_t,N> & a, const double & b)
+{
+  a.val = a.val - b;
+};
+
+//Multiplication equals operator
+template<typename v_t, unsigned N, typename E>
+FORCE_INLINE void operator*=(dualVecNumber<v_t,N> & a, const dualVecExpr<E> & b)
+{
+  a = dualVecProd<dualVecNumber<v_t,N>,E>(a, b.self());
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE void operator*=(dualVecNumber<v_t,N> & a, const double & b)
+{
+  a = dualVecAffine<dualVecNumber<v_t,N>>(a, b, 0.0);
+};
+
+//Divide equals operator
+template<typename v_t, unsigned N, typename E>
+FORCE_INLINE void operator/=(dualVecNumber<v_t,N> & a, const dualVecExpr<E> & b)
+{
+  a = dualVecQuot<dualVecNumber<v_t,N>,E>(a, b.self());
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE void operator/=(dualVecNumber<v_t,N> & a, const double & b)
+{
+  a = dualVecAffine<dualVecNumber<v_t,N>>(a, 1.0/b, 0.0);
+};
+
+/***************************************\
+!
+!  Dual-Dual number operations
+!
+\***************************************/
+//Multiplication operator
+template<typename A, typename B>
+FORCE_INLINE dualVecProd<A,B> operator*(const dualVecExpr<A> & a, const dualVecExpr<B> & b)
+{
+  return dualVecProd<A,B>(a.self(), b.self());
+};
+
+//Division operator
+template<typename A, typename B>
+FORCE_INLINE dualVecQuot<A,B> operator/(const dualVecExpr<A> & a, const dualVecExpr<B> & b)
+{
+  return dualVecQuot<A,B>(a.self(), b.self());
+};
+
+//Addition operator
+template<typename A, typename B>
+FORCE_INLINE dualVecSum<A,B,1> operator+(const dualVecExpr<A> & a, const dualVecExpr<B> & b)
+{
+  return dualVecSum<A,B,1>(a.self(), b.self());
+};
+
+//Subtraction operator
+template<typename A, typename B>
+FORCE_INLINE dualVecSum<A,B,-1> operator-(const dualVecExpr<A> & a, const dualVecExpr<B> & b)
+{
+  return dualVecSum<A,B,-1>(a.self(), b.self());
+};
+
+//Negation operator
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator-(const dualVecExpr<A> & a)
+{
+  return dualVecAffine<A>(a.self(), -1.0, 0.0);
+};
+
+/***************************************\
+!
+!  Dual number comparison operations
+!  (only the primal value is compared)
+!
+\***************************************/
+//equivalence operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator==(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return (a.self().val == b.self().val);};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator==(const dualVecExpr<A> & a, const double b){return (a.self().val == b);};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator==(const double b, const dualVecExpr<A> & a){return (a.self().val == b);};
+
+
+//inequivalence operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator!=(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return (a.self().val != b.self().val);};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator!=(const double a, const dualVecExpr<A> & b){return (a != b.self().val);};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator!=(const dualVecExpr<A> & a, const double b){return (a.self().val != b);};
+
+
+//more than operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator>(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return a.self().val > b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator>(const double a, const dualVecExpr<A> & b){return a > b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator>(const dualVecExpr<A> & a, const double b){return a.self().val > b;};
+
+
+//less than operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator<(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return a.self().val < b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator<(const double a, const dualVecExpr<A> & b){return a < b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator<(const dualVecExpr<A> & a, const double b){return a.self().val < b;};
+
+
+//more than equal operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator>=(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return a.self().val >= b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator>=(const dualVecExpr<A> & a, const double b){return a.self().val >= b;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator>=(const double a, const dualVecExpr<A> & b){return a >= b.self().val;};
+
+
+//less than equal operator
+template<typename A, typename B>
+FORCE_INLINE constexpr bool operator<=(const dualVecExpr<A> & a, const dualVecExpr<B> & b){return a.self().val <= b.self().val;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator<=(const dualVecExpr<A> & a, const double b){return a.self().val <= b;};
+
+template<typename A>
+FORCE_INLINE constexpr bool operator<=(const double a, const dualVecExpr<A> & b){return a <= b.self().val;};
+
+
+/***************************************\
+!
+!  Number-Dual number operations
+!  (float and int promote to double)
+!
+\***************************************/
+//Multiplication operator
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator*(const dualVecExpr<A> & dNum, const double Num){return dualVecAffine<A>(dNum.self(), Num, 0.0);};
+
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator*(const double Num, const dualVecExpr<A> & dNum){return dualVecAffine<A>(dNum.self(), Num, 0.0);};
+
+//Division operator
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator/(const dualVecExpr<A> & dNum, const double Num){return dualVecAffine<A>(dNum.self(), 1.0/Num, 0.0);};
+
+template<typename A>
+FORCE_INLINE dualVecRecip<A> operator/(const double Num, const dualVecExpr<A> & dNum){return dualVecRecip<A>(dNum.self(), Num);};
+
+//Addition operator
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator+(const dualVecExpr<A> & dNum, const double Num){return dualVecAffine<A>(dNum.self(), 1.0, Num);};
+
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator+(const double Num, const dualVecExpr<A> & dNum){return dualVecAffine<A>(dNum.self(), 1.0, Num);};
+
+//Subtraction operator
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator-(const dualVecExpr<A> & dNum, const double Num){return dualVecAffine<A>(dNum.self(), 1.0, -Num);};
+
+template<typename A>
+FORCE_INLINE dualVecAffine<A> operator-(const double Num, const dualVecExpr<A> & dNum){return dualVecAffine<A>(dNum.self(), -1.0, Num);};
+
+
+/***************************************\
+!
+!  Templated maths of an expression,
+!  the expression is evaluated first
+!  and the dualVecNumber function used
+!
+\***************************************/
+#define DUALVEC_EXPR_FUNC1(FUNC)                                          \
+template<typename E, typename = std::enable_if_t<isExprNumber<E>::value>> \
+FORCE_INLINE typename E::dual_t FUNC(const dualVecExpr<E> & e)            \
+{                                                                         \
+  typename E::dual_t x(e);                                                \
+  return FUNC(x);                                                         \
+};
+
+#define DUALVEC_EXPR_FUNC2(FUNC)                                          \
+template<typename A, typename B, typename = std::enable_if_t<isExprNumber<A>::value or isExprNumber<B>::value>> \
+FORCE_INLINE typename A::dual_t FUNC(const dualVecExpr<A> & a, const dualVecExpr<B> & b) \
+{                                                                         \
+  typename A::dual_t x(a), y(b);                                          \
+  return FUNC(x, y);                                                      \
+};
+
+DUALVEC_EXPR_FUNC1(exp)   DUALVEC_EXPR_FUNC1(log)   DUALVEC_EXPR_FUNC1(log10)
+DUALVEC_EXPR_FUNC1(exp2)  DUALVEC_EXPR_FUNC1(expm1) DUALVEC_EXPR_FUNC1(log2)
+DUALVEC_EXPR_FUNC1(logb)  DUALVEC_EXPR_FUNC1(log1p) DUALVEC_EXPR_FUNC1(sqrt)
+DUALVEC_EXPR_FUNC1(cbrt)  DUALVEC_EXPR_FUNC1(sin)   DUALVEC_EXPR_FUNC1(cos)
+DUALVEC_EXPR_FUNC1(tan)   DUALVEC_EXPR_FUNC1(acos)  DUALVEC_EXPR_FUNC1(asin)
+DUALVEC_EXPR_FUNC1(atan)  DUALVEC_EXPR_FUNC1(cosh)  DUALVEC_EXPR_FUNC1(sinh)
+DUALVEC_EXPR_FUNC1(tanh)  DUALVEC_EXPR_FUNC1(acosh) DUALVEC_EXPR_FUNC1(asinh)
+DUALVEC_EXPR_FUNC1(atanh) DUALVEC_EXPR_FUNC1(abs)   DUALVEC_EXPR_FUNC1(fabs)
+DUALVEC_EXPR_FUNC1(erf)   DUALVEC_EXPR_FUNC1(erfc)
+DUALVEC_EXPR_FUNC2(pow)   DUALVEC_EXPR_FUNC2(hypot) DUALVEC_EXPR_FUNC2(ldexp)
+
+//Integer and rational powers of an expression
+template<int N, typename E, typename = std::enable_if_t<isExprNumber<E>::value>>
+FORCE_INLINE typename E::dual_t pow(const dualVecExpr<E> & e)
+{
+  typename E::dual_t x(e);
+  return pow<N>(x);
+};
+
+template<int P, int Q, typename E, typename = std::enable_if_t<isExprNumber<E>::value>>
+FORCE_INLINE typename E::dual_t pow(const dualVecExpr<E> & e)
+{
+  typename E::dual_t x(e);
+  return pow<P,Q>(x);
+};
+
+template<typename E, typename = std::enable_if_t<isExprNumber<E>::value>>
+FORCE_INLINE typename E::dual_t pow(const dualVecExpr<E> & e, const int n)
+{
+  typename E::dual_t x(e);
+  return pow(x, n);
+};
+
+
+/***************************************\
+!
+!  Evaluate the gradient of a scalar
+!  functional of N inputs with a single
+!  (vector-mode) evaluation, F must be
+!  callable as F(const dualVecNumber*)
+!  and the value of F is returned
+!
+\***************************************/
+template<unsigned N, typename Number, typename Functional>
+FORCE_INLINE Number tGradient(const Functional & F, const Number x[], Number dFdx[])
+{
+  dualVecNumber<Number,N> xDual[N];
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) xDual[I] = dualVecNumber<Number,N>(x[I],I);
+
+  dualVecNumber<Number,N> FDual = F(xDual);
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) dFdx[I] = FDual.grad[I];
+  return FDual.val;
+};
@@ -0,0 +1,229 @@
+#pragma once
+#include "../UtilityObjects/macros.hpp"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/***************************************\
+!
+!  SIMD register width (in bytes) used
+!  for aligning and padding packed
+!  lanes, set by the instruction set
+!  the code is compiled for
+!
+\***************************************/
+#if defined(__AVX512F__)
+#define SIMD_BYTES 64
+#elif defined(__AVX2__)
+#define SIMD_BYTES 32
+#else
+#define SIMD_BYTES 16
+#endif
+
+//Number of lanes N padded up to a
+//whole number of SIMD registers
+template<typename value_t, unsigned N>
+constexpr unsigned simdPaddedLanes()
+{
+  constexpr unsigned W = (SIMD_BYTES/sizeof(value_t) > 0)? SIMD_BYTES/sizeof(value_t):1;
+  return ((N + W - 1)/W)*W;
+};
+
+/***************************************\
+!
+!  Packed lane kernels
+!  (scalar fallback)
+!
+!  All the lanes are aligned to
+!  SIMD_BYTES and padded to NPad
+!  these are the only operations
+!  needed to propagate the derivative
+!  lanes of a dual number:
+!    out = a*x + b*y
+!    out = a*x
+!    out = x + y
+!    out = x - y
+!
+\***************************************/
+template<typename value_t, unsigned NPad>
+struct laneOps{
+  static FORCE_INLINE void axpby(value_t *out, const value_t a, const value_t *x
+                                             , const value_t b, const value_t *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I++) out[I] = a*x[I] + b*y[I];
+  };
+
+  static FORCE_INLINE void scale(value_t *out, const value_t a, const value_t *x)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I++) out[I] = a*x[I];
+  };
+
+  static FORCE_INLINE void add(value_t *out, const value_t *x, const value_t *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I++) out[I] = x[I] + y[I];
+  };
+
+  static FORCE_INLINE void sub(value_t *out, const value_t *x, const value_t *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I++) out[I] = x[I] - y[I];
+  };
+};
+
+/***************************************\
+!
+!  Packed lane kernels
+!  (AVX-512 double/float)
+!
+\***************************************/
+#if defined(__AVX512F__)
+template<unsigned NPad>
+struct laneOps<double,NPad>{
+  static FORCE_INLINE void axpby(double *out, const double a, const double *x
+                                            , const double b, const double *y)
+  {
+    const __m512d A=_mm512_set1_pd(a), B=_mm512_set1_pd(b);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8){
+      __m512d By = _mm512_mul_pd(B, _mm512_load_pd(y+I));
+      _mm512_store_pd(out+I, _mm512_fmadd_pd(A, _mm512_load_pd(x+I), By));
+    }
+  };
+
+  static FORCE_INLINE void scale(double *out, const double a, const double *x)
+  {
+    const __m512d A=_mm512_set1_pd(a);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm512_store_pd(out+I, _mm512_mul_pd(A, _mm512_load_pd(x+I)));
+  };
+
+  static FORCE_INLINE void add(double *out, const double *x, const double *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm512_store_pd(out+I, _mm512_add_pd(_mm512_load_pd(x+I), _mm512_load_pd(y+I)));
+  };
+
+  static FORCE_INLINE void sub(double *out, const double *x, const double *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm512_store_pd(out+I, _mm512_sub_pd(_mm512_load_pd(x+I), _mm512_load_pd(y+I)));
+  };
+};
+
+template<unsigned NPad>
+struct laneOps<float,NPad>{
+  static FORCE_INLINE void axpby(float *out, const float a, const float *x
+                                           , const float b, const float *y)
+  {
+    const __m512 A=_mm512_set1_ps(a), B=_mm512_set1_ps(b);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=16){
+      __m512 By = _mm512_mul_ps(B, _mm512_load_ps(y+I));
+      _mm512_store_ps(out+I, _mm512_fmadd_ps(A, _mm512_load_ps(x+I), By));
+    }
+  };
+
+  static FORCE_INLINE void scale(float *out, const float a, const float *x)
+  {
+    const __m512 A=_mm512_set1_ps(a);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=16) _mm512_store_ps(out+I, _mm512_mul_ps(A, _mm512_load_ps(x+I)));
+  };
+
+  static FORCE_INLINE void add(float *out, const float *x, const float *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=16) _mm512_store_ps(out+I, _mm512_add_ps(_mm512_load_ps(x+I), _mm512_load_ps(y+I)));
+  };
+
+  static FORCE_INLINE void sub(float *out, const float *x, const float *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=16) _mm512_store_ps(out+I, _mm512_sub_ps(_mm512_load_ps(x+I), _mm512_load_ps(y+I)));
+  };
+};
+
+/***************************************\
+!
+!  Packed lane kernels
+!  (AVX2 double/float)
+!
+\***************************************/
+#elif defined(__AVX2__)
+template<unsigned NPad>
+struct laneOps<double,NPad>{
+  static FORCE_INLINE void axpby(double *out, const double a, const double *x
+                                            , const double b, const double *y)
+  {
+    const __m256d A=_mm256_set1_pd(a), B=_mm256_set1_pd(b);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=4){
+      __m256d By = _mm256_mul_pd(B, _mm256_load_pd(y+I));
+#if defined(__FMA__)
+      _mm256_store_pd(out+I, _mm256_fmadd_pd(A, _mm256_load_pd(x+I), By));
+#else
+      _mm256_store_pd(out+I, _mm256_add_pd(_mm256_mul_pd(A, _mm256_load_pd(x+I)), By));
+#endif
+    }
+  };
+
+  static FORCE_INLINE void scale(double *out, const double a, const double *x)
+  {
+    const __m256d A=_mm256_set1_pd(a);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=4) _mm256_store_pd(out+I, _mm256_mul_pd(A, _mm256_load_pd(x+I)));
+  };
+
+  static FORCE_INLINE void add(double *out, const double *x, const double *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=4) _mm256_store_pd(out+I, _mm256_add_pd(_mm256_load_pd(x+I), _mm256_load_pd(y+I)));
+  };
+
+  static FORCE_INLINE void sub(double *out, const double *x, const double *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=4) _mm256_store_pd(out+I, _mm256_sub_pd(_mm256_load_pd(x+I), _mm256_load_pd(y+I)));
+  };
+};
+
+template<unsigned NPad>
+struct laneOps<float,NPad>{
+  static FORCE_INLINE void axpby(float *out, const float a, const float *x
+                                           , const float b, const float *y)
+  {
+    const __m256 A=_mm256_set1_ps(a), B=_mm256_set1_ps(b);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8){
+      __m256 By = _mm256_mul_ps(B, _mm256_load_ps(y+I));
+#if defined(__FMA__)
+      _mm256_store_ps(out+I, _mm256_fmadd_ps(A, _mm256_load_ps(x+I), By));
+#else
+      _mm256_store_ps(out+I, _mm256_add_ps(_mm256_mul_ps(A, _mm256_load_ps(x+I)), By));
+#endif
+    }
+  };
+
+  static FORCE_INLINE void scale(float *out, const float a, const float *x)
+  {
+    const __m256 A=_mm256_set1_ps(a);
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm256_store_ps(out+I, _mm256_mul_ps(A, _mm256_load_ps(x+I)));
+  };
+
+  static FORCE_INLINE void add(float *out, const float *x, const float *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm256_store_ps(out+I, _mm256_add_ps(_mm256_load_ps(x+I), _mm256_load_ps(y+I)));
+  };
+
+  static FORCE_INLINE void sub(float *out, const float *x, const float *y)
+  {
+    #pragma unroll
+    for(unsigned I=0; I<NPad; I+=8) _mm256_store_ps(out+I, _mm256_sub_ps(_mm256_load_ps(x+I), _mm256_load_ps(y+I)));
+  };
+};
+#endif
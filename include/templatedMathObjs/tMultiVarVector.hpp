@@ -28,6 +28,9 @@
 
 For non-linear problems
 D = f(B.x);
+and the Jacobian action (PARTIAL) is
+J.v = B^T.D'(B.x).B.v
+with D' [VarSize x VarSize] stored at the integration-points
 **/
 
 
@@ -94,15 +97,17 @@ void AddVarIteratorDat(VarIterData<uint> & data
   if( data.Voffsets.size() == 0) data.Voffsets.push_back(0);
   int Isof=data.Soffsets.size()-1;
   int Ivof=data.Voffsets.size()-1;
-  int tmp_size=0;
+  int tmp_size=1;
 
+  //The tensor size is the product of
+  //its dimensions (1 for a scalar)
   for(uint I=0; I<TRank; I++){
     data.sizes.push_back(sizes[I]);
-    tmp_size += sizes[I];
+    tmp_size *= sizes[I];
   }
   data.Tsize += tmp_size;
-  data.Soffsets.push_back(data.Soffsets[Isof]+tmp_size);
-  data.Voffsets.push_back(data.Voffsets[Ivof]+TRank);
+  data.Soffsets.push_back(data.Soffsets[Isof]+TRank);
+  data.Voffsets.push_back(data.Voffsets[Ivof]+tmp_size);
 };
 
 /**
@@ -152,14 +157,14 @@ void MakeMultiVarMFEMIter(const mfem::MemoryType  & mt
 //multi-dimensional var-data
 // [Almost exclusively used]
 template<typename uint>
-FORCE_INLINE uint MultiVarFwdIterator(const MFEMVarIterData<uint> data, const uint VarID, uint Iters[])
+FORCE_INLINE uint MultiVarFwdIterator(const MFEMVarIterData<uint> & data, const uint VarID, uint Iters[])
 {
   uint Iter1D=0, Iter_tmp=0;
   #pragma unroll
-  for(uint I=0; I < data.TRank[VarID]; I++){
+  for(uint I=0; I < data.TRanks[VarID]; I++){
     Iter_tmp = Iters[I];
     #pragma unroll
-    for(uint J=I+1; J < data.TRank[VarID]; I++){
+    for(uint J=I+1; J < data.TRanks[VarID]; J++){
       Iter_tmp *= data.sizes[data.Soffsets[VarID] + J];
     }
     Iter1D += Iter_tmp;
@@ -171,19 +176,19 @@ FORCE_INLINE uint MultiVarFwdIterator(const MFEMVarIterData<uint> data, const ui
 //multi-dimensional var-data
 // [Unlikely to be ever used]
 template<typename uint>
-FORCE_INLINE void MultiVarInvIterator(const MFEMVarIterData<uint> data
+FORCE_INLINE void MultiVarInvIterator(const MFEMVarIterData<uint> & data
                                     , const uint VarID
                                     , const uint vec_Iter
                                     , uint Iters[])
 {
   uint Iter_tmp, Iter1D = vec_Iter - data.Voffsets[VarID];
   #pragma unroll
-  for(uint I=0; I < data.TRank[VarID]; I++){
+  for(uint I=0; I < data.TRanks[VarID]; I++){
     Iter_tmp = Iter1D;
     #pragma unroll
-    for(uint J=I+1; J < data.TRank[VarID]; I++){
+    for(uint J=I+1; J < data.TRanks[VarID]; J++){
       Iter_tmp /= data.sizes[data.Soffsets[VarID] + J];
     }
-    Iters[I] = Iter_tmp;
+    Iters[I] = Iter_tmp % data.sizes[data.Soffsets[VarID] + I];
   }
 };
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include "../UtilityObjects/macros.hpp"
+
+/***************************************\
+!
+!  Non-owning view of a contiguous
+!  array of numbers (C++17 has no
+!  std::span), used by the batched
+!  templated maths functions
+!
+\***************************************/
+template<typename Numeric>
+struct tSpan{
+  Numeric     *ptr;
+  std::size_t len;
+
+  FORCE_INLINE constexpr tSpan(Numeric *data_, const std::size_t size_): ptr(data_), len(size_){};
+
+  //Non-const to const views
+  template<typename U, typename = std::enable_if_t<std::is_convertible<U(*)[], Numeric(*)[]>::value>>
+  FORCE_INLINE constexpr tSpan(const tSpan<U> & other): ptr(other.data()), len(other.size()){};
+
+  //Access Data
+  FORCE_INLINE constexpr Numeric *data() const {return ptr;};
+  FORCE_INLINE constexpr std::size_t size() const {return len;};
+  FORCE_INLINE constexpr Numeric &operator[](const std::size_t I) const {return ptr[I];};
+  FORCE_INLINE constexpr Numeric *begin() const {return ptr;};
+  FORCE_INLINE constexpr Numeric *end() const {return ptr + len;};
+};
+
+//Make a view of a pointer and size
+template<typename Numeric>
+FORCE_INLINE constexpr tSpan<Numeric> tMakeSpan(Numeric *data, const std::size_t size)
+{
+  return tSpan<Numeric>(data, size);
+};
@@ -38,4 +38,10 @@ struct tVectorMFEM{
   //Access Data
   FORCE_INLINE Numeric &operator()(int I) {return data[I];};
   FORCE_INLINE Numeric &operator[](int I) {return data[I];};
+
+  //Host/device pointers (as mfem::Vector)
+  const Numeric *Read(bool on_dev=true) const {return mfem::Read(data, size, on_dev);};
+  Numeric *Write(bool on_dev=true) {return mfem::Write(data, size, on_dev);};
+  Numeric *ReadWrite(bool on_dev=true) {return mfem::ReadWrite(data, size, on_dev);};
+  int Size() const {return size;};
 };
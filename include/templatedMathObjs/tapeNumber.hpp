@@ -0,0 +1,475 @@
+#pragma once
+#include <vector>
+#include "../UtilityObjects/macros.hpp"
+
+/***************************************\
+!
+!  Reverse-mode (adjoint) Numbers
+!
+!  Every operation on a tapeNumber
+!  records a node on a tape holding
+!  (at most two) parent indices and the
+!  local partial derivatives, a single
+!  backward sweep over the tape then
+!  gives the derivative of one output
+!  with regards to every input, i.e.
+!  the cost is independent of the
+!  number of inputs.
+!
+!  The tape is host only, one per
+!  thread (thread_local), preallocated
+!  and reset (not freed) between
+!  evaluations so it is reused across
+!  quadrature points and elements
+!
+\***************************************/
+//A single recorded operation
+template<typename value_t>
+struct tapeNode{
+  int     parent[2];
+  value_t partial[2];
+};
+
+//The tape of recorded operations
+template<typename value_t>
+struct adjointTape{
+  std::vector<tapeNode<value_t>> nodes;
+  std::vector<value_t>           adjoints;
+  int nNodes=0;
+
+  //Preallocate the tape
+  void reserve(const int nMax){
+    if(nMax > int(nodes.size())){
+      nodes.resize(nMax);
+      adjoints.resize(nMax);
+    }
+  };
+
+  //Clear the tape (keeps the memory)
+  void reset(){nNodes=0;};
+
+  //Record a node and return its index
+  inline int push(const int p0, const value_t d0, const int p1, const value_t d1){
+    if(nNodes == int(nodes.size())) reserve(2*nNodes + 64);
+    nodes[nNodes].parent[0]  = p0;
+    nodes[nNodes].parent[1]  = p1;
+    nodes[nNodes].partial[0] = d0;
+    nodes[nNodes].partial[1] = d1;
+    nNodes++;
+    return nNodes-1;
+  };
+
+  //Backward sweep seeding the
+  //adjoint of the output node
+  void backward(const int output){
+    for(int I=0; I<nNodes; I++) adjoints[I] = 0.0;
+    if(output < 0) return;
+    adjoints[output] = 1.0;
+    for(int I=output; I>=0; I--){
+      const value_t adj = adjoints[I];
+      if(adj == 0.0) continue;
+      for(int K=0; K<2; K++){
+        const int P = nodes[I].parent[K];
+        if(P >= 0) adjoints[P] += nodes[I].partial[K]*adj;
+      }
+    }
+  };
+};
+
+//The per thread tape
+template<typename value_t>
+adjointTape<value_t> & threadTape()
+{
+  static thread_local adjointTape<value_t> tape;
+  return tape;
+};
+
+//Preallocate the tape of the calling thread
+template<typename value_t>
+void tapeReserve(const int nMax)
+{
+  threadTape<value_t>().reserve(nMax);
+};
+
+
+/***************************************\
+!
+!  The taped number, constants and
+!  passive values have no node (index=-1)
+!  and are never recorded
+!
+\***************************************/
+template<typename value_t>
+struct tapeNumber{
+  value_t val;
+  int     index;
+
+  inline tapeNumber(value_t r=0.0): val(r), index(-1){};
+  inline tapeNumber(value_t r, int idx): val(r), index(idx){};
+};
+
+//The primal value of a taped number
+template<typename v_t>
+inline auto primalValue(const tapeNumber<v_t> & a){return primalValue(a.val);};
+
+//Record the result of a unary operation
+//f(a) with the partial df/da
+template<typename v_t>
+inline tapeNumber<v_t> tapeUnary(const tapeNumber<v_t> & a, const v_t f, const v_t dfda)
+{
+  if(a.index < 0) return tapeNumber<v_t>(f);
+  return tapeNumber<v_t>(f, threadTape<v_t>().push(a.index, dfda, -1, 0.0));
+};
+
+//Record the result of a binary operation
+//f(a,b) with the partials df/da and df/db
+template<typename v_t>
+inline tapeNumber<v_t> tapeBinary(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b
+                                , const v_t f, const v_t dfda, const v_t dfdb)
+{
+  if((a.index < 0)and(b.index < 0)) return tapeNumber<v_t>(f);
+  return tapeNumber<v_t>(f, threadTape<v_t>().push(a.index, dfda, b.index, dfdb));
+};
+
+/***************************************\
+!
+!  Tape-Tape number
+!  Equivalence/augmentation operations
+!
+\***************************************/
+//Increment operator
+template<typename v_t>
+inline void operator+=(tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  a = tapeBinary<v_t>(a, b, a.val + b.val, 1.0, 1.0);
+};
+
+template<typename v_t>
+inline void operator+=(tapeNumber<v_t> & a, const double & b)
+{
+  a = tapeUnary<v_t>(a, a.val + b, 1.0);
+};
+
+template<typename v_t>
+inline void operator+=(tapeNumber<v_t> & a, const float & b)
+{
+  a = tapeUnary<v_t>(a, a.val + b, 1.0);
+};
+
+//Decrement operator
+template<typename v_t>
+inline void operator-=(tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  a = tapeBinary<v_t>(a, b, a.val - b.val, 1.0, -1.0);
+};
+
+template<typename v_t>
+inline void operator-=(tapeNumber<v_t> & a, const double & b)
+{
+  a = tapeUnary<v_t>(a, a.val - b, 1.0);
+};
+
+template<typename v_t>
+inline void operator-=(tapeNumber<v_t> & a, const float & b)
+{
+  a = tapeUnary<v_t>(a, a.val - b, 1.0);
+};
+
+//Multiplication equals operator
+template<typename v_t>
+inline void operator*=(tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  a = tapeBinary<v_t>(a, b, a.val*b.val, b.val, a.val);
+};
+
+template<typename v_t>
+inline void operator*=(tapeNumber<v_t> & a, const double & b)
+{
+  a = tapeUnary<v_t>(a, a.val*b, b);
+};
+
+template<typename v_t>
+inline void operator*=(tapeNumber<v_t> & a, const float & b)
+{
+  a = tapeUnary<v_t>(a, a.val*b, b);
+};
+
+//Divide equals operator
+template<typename v_t>
+inline void operator/=(tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  v_t invB = 1.0/b.val;
+  a = tapeBinary<v_t>(a, b, a.val*invB, invB, -a.val*invB*invB);
+};
+
+template<typename v_t>
+inline void operator/=(tapeNumber<v_t> & a, const double & b)
+{
+  a = tapeUnary<v_t>(a, a.val/b, 1.0/b);
+};
+
+template<typename v_t>
+inline void operator/=(tapeNumber<v_t> & a, const float & b)
+{
+  a = tapeUnary<v_t>(a, a.val/b, 1.0/b);
+};
+
+/***************************************\
+!
+!  Tape-Tape number operations
+!
+\***************************************/
+//Multiplication operator
+template<typename v_t>
+inline tapeNumber<v_t> operator*(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  return tapeBinary<v_t>(a, b, a.val*b.val, b.val, a.val);
+};
+
+//Division operator
+template<typename v_t>
+inline tapeNumber<v_t> operator/(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  v_t invB = 1.0/b.val;
+  return tapeBinary<v_t>(a, b, a.val*invB, invB, -a.val*invB*invB);
+};
+
+//Addition operator
+template<typename v_t>
+inline tapeNumber<v_t> operator+(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  return tapeBinary<v_t>(a, b, a.val + b.val, 1.0, 1.0);
+};
+
+//Subtraction operator
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b)
+{
+  return tapeBinary<v_t>(a, b, a.val - b.val, 1.0, -1.0);
+};
+
+//Negation operator
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const tapeNumber<v_t> & a)
+{
+  return tapeUnary<v_t>(a, -a.val, -1.0);
+};
+
+/***************************************\
+!
+!  Tape number comparison operations
+!  (only the primal value is compared)
+!
+\***************************************/
+//equivalence operator
+template<typename v_t>
+inline bool operator==(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return (a.val == b.val);};
+
+template<typename v_t, typename Number>
+inline bool operator==(const tapeNumber<v_t> & a, const Number b){return (a.val == b);};
+
+template<typename v_t, typename Number>
+inline bool operator==(const Number b, const tapeNumber<v_t> & a){return (a.val == b);};
+
+
+//inequivalence operator
+template<typename v_t>
+inline bool operator!=(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return (a.val != b.val);};
+
+template<typename v_t, typename Number>
+inline bool operator!=(const Number a, const tapeNumber<v_t> & b){return (a != b.val);};
+
+template<typename v_t, typename Number>
+inline bool operator!=(const tapeNumber<v_t> & a, const Number b){return (a.val != b);};
+
+
+//more than operator
+template<typename v_t>
+inline bool operator>(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return a.val > b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator>(const Number a, const tapeNumber<v_t> & b){return a > b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator>(const tapeNumber<v_t> & a, const Number b){return a.val > b;};
+
+
+//less than operator
+template<typename v_t>
+inline bool operator<(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return a.val < b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator<(const Number a, const tapeNumber<v_t> & b){return a < b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator<(const tapeNumber<v_t> & a, const Number b){return a.val < b;};
+
+
+//more than equal operator
+template<typename v_t>
+inline bool operator>=(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return a.val >= b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator>=(const tapeNumber<v_t> & a, const Number b){return a.val >= b;};
+
+template<typename v_t, typename Number>
+inline bool operator>=(const Number a, const tapeNumber<v_t> & b){return a >= b.val;};
+
+
+//less than equal operator
+template<typename v_t>
+inline bool operator<=(const tapeNumber<v_t> & a, const tapeNumber<v_t> & b){return a.val <= b.val;};
+
+template<typename v_t, typename Number>
+inline bool operator<=(const tapeNumber<v_t> & a, const Number b){return a.val <= b;};
+
+template<typename v_t, typename Number>
+inline bool operator<=(const Number a, const tapeNumber<v_t> & b){return a <= b.val;};
+
+
+/***************************************\
+!
+!  Number-Tape number operations
+!
+\***************************************/
+///////////
+//Multiplication operator
+///////////
+template<typename v_t>
+inline tapeNumber<v_t> operator*(const tapeNumber<v_t> & tNum, const double Num){return tapeUnary<v_t>(tNum, tNum.val*Num, Num);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator*(const tapeNumber<v_t> & tNum, const float Num){return tapeUnary<v_t>(tNum, tNum.val*Num, Num);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator*(const double Num, const tapeNumber<v_t> & tNum){return tNum*Num;};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator*(const float Num, const tapeNumber<v_t> & tNum){return tNum*Num;};
+
+///////////
+//Division operator
+///////////
+template<typename v_t>
+inline tapeNumber<v_t> operator/(const tapeNumber<v_t> & tNum, const double Num){return tapeUnary<v_t>(tNum, tNum.val/Num, 1.0/Num);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator/(const tapeNumber<v_t> & tNum, const float Num){return tapeUnary<v_t>(tNum, tNum.val/Num, 1.0/Num);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator/(const double Num, const tapeNumber<v_t> & tNum)
+{
+  v_t invB = 1.0/tNum.val;
+  return tapeUnary<v_t>(tNum, Num*invB, -Num*invB*invB);
+};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator/(const float Num, const tapeNumber<v_t> & tNum){return double(Num)/tNum;};
+
+///////////
+//Addition operator
+///////////
+template<typename v_t>
+inline tapeNumber<v_t> operator+(const tapeNumber<v_t> & tNum, const double Num){return tapeUnary<v_t>(tNum, tNum.val + Num, 1.0);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator+(const tapeNumber<v_t> & tNum, const float Num){return tapeUnary<v_t>(tNum, tNum.val + Num, 1.0);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator+(const double Num, const tapeNumber<v_t> & tNum){return tNum + Num;};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator+(const float Num, const tapeNumber<v_t> & tNum){return tNum + Num;};
+
+///////////
+//Subtraction operator
+///////////
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const tapeNumber<v_t> & tNum, const double Num){return tapeUnary<v_t>(tNum, tNum.val - Num, 1.0);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const tapeNumber<v_t> & tNum, const float Num){return tapeUnary<v_t>(tNum, tNum.val - Num, 1.0);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const double Num, const tapeNumber<v_t> & tNum){return tapeUnary<v_t>(tNum, Num - tNum.val, -1.0);};
+
+template<typename v_t>
+inline tapeNumber<v_t> operator-(const float Num, const tapeNumber<v_t> & tNum){return tapeUnary<v_t>(tNum, Num - tNum.val, -1.0);};
+
+
+/***************************************\
+!
+!  Integer-Tape number operations, the
+!  integral scalars (2*x, x/3, 1 - x)
+!  promote to double (otherwise the
+!  double and float overloads are
+!  ambiguous)
+!
+\***************************************/
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline void operator+=(tapeNumber<v_t> & a, const Int b){a += double(b);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline void operator-=(tapeNumber<v_t> & a, const Int b){a -= double(b);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline void operator*=(tapeNumber<v_t> & a, const Int b){a *= double(b);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline void operator/=(tapeNumber<v_t> & a, const Int b){a /= double(b);};
+
+//Multiplication operator
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator*(const tapeNumber<v_t> & tNum, const Int Num){return tNum*double(Num);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator*(const Int Num, const tapeNumber<v_t> & tNum){return tNum*double(Num);};
+
+//Division operator
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator/(const tapeNumber<v_t> & tNum, const Int Num){return tNum/double(Num);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator/(const Int Num, const tapeNumber<v_t> & tNum){return double(Num)/tNum;};
+
+//Addition operator
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator+(const tapeNumber<v_t> & tNum, const Int Num){return tNum + double(Num);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator+(const Int Num, const tapeNumber<v_t> & tNum){return tNum + double(Num);};
+
+//Subtraction operator
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator-(const tapeNumber<v_t> & tNum, const Int Num){return tNum - double(Num);};
+
+template<typename v_t, typename Int, typename = tIntegralArg<Int>>
+inline tapeNumber<v_t> operator-(const Int Num, const tapeNumber<v_t> & tNum){return double(Num) - tNum;};
+
+/***************************************\
+!
+!  Evaluate the gradient of a scalar
+!  functional of nInps inputs with one
+!  forward sweep (recording the tape)
+!  and one backward sweep, F must be
+!  callable as F(const tapeNumber*)
+!  and the value of F is returned
+!
+\***************************************/
+template<typename Number, typename Functional>
+Number tAdjointGradient(const Functional & F, const Number x[], Number dFdx[], const unsigned nInps)
+{
+  adjointTape<Number> & tape = threadTape<Number>();
+  tape.reset();
+
+  //Record the inputs as the first nodes
+  static thread_local std::vector<tapeNumber<Number>> xTape;
+  if(xTape.size() < nInps) xTape.resize(nInps);
+  for(unsigned I=0; I<nInps; I++) xTape[I] = tapeNumber<Number>(x[I], tape.push(-1, 0.0, -1, 0.0));
+
+  //Forward and backward sweeps
+  tapeNumber<Number> FTape = F(xTape.data());
+  tape.backward(FTape.index);
+  for(unsigned I=0; I<nInps; I++) dFdx[I] = ((FTape.index < 0)? 0.0:tape.adjoints[xTape[I].index]);
+  return FTape.val;
+};
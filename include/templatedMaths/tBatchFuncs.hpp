@@ -0,0 +1,343 @@
+#pragma once
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include "../UtilityObjects/macros.hpp"
+#include "../templatedMathObjs/tSpan.hpp"
+#include "tExpLogFuncs.hpp"
+#include "tTrigFuncs.hpp"
+#include "tDualFuncs.hpp"
+
+/*****************************************\
+!
+!  Batched templated maths, evaluates a
+!  function on a contiguous array of
+!  numbers (e.g. every quadrature point
+!  of an element or chunk of elements)
+!   exp(tSpan<const T> x, tSpan<T> y)
+!  the first min(x.size, y.size) entries
+!  are evaluated
+!
+!  For double/float the exp, log, sin
+!  and cos batches are branch-free loops
+!  (range reduction by the round to
+!  nearest "magic number" trick, bit
+!  manipulation of the exponent and
+!  integer masks for the special values)
+!  so they vectorise, the other functions
+!  and the dual types are evaluated point
+!  by point with the native function or
+!  the analytic dual overloads
+!
+\*****************************************/
+//The integer type and constants of
+//the floating point bit layout
+template<typename T> struct tFloatBits;
+
+template<> struct tFloatBits<double>{
+  using int_t = INT64;
+  static constexpr int  mantBits = 52;
+  static constexpr INT64 bias = 1023, expMask = 0x7ff;
+  static constexpr INT64 mantMask = 0x000fffffffffffffLL;
+  static constexpr INT64 absMask  = 0x7fffffffffffffffLL;
+  static constexpr double magic = 6755399441055744.0;      //1.5*2^52
+  static constexpr INT64  magicBits = 0x4338000000000000LL;
+  static constexpr double two_m = 4503599627370496.0;      //2^52
+  static constexpr INT64  two_mBits = 0x4330000000000000LL;
+  static constexpr double subScale = 18014398509481984.0;  //2^54
+  static constexpr int    subShift = 54;
+};
+
+template<> struct tFloatBits<float>{
+  using int_t = int;
+  static constexpr int mantBits = 23;
+  static constexpr int bias = 127, expMask = 0xff;
+  static constexpr int mantMask = 0x007fffff;
+  static constexpr int absMask  = 0x7fffffff;
+  static constexpr float magic = 12582912.0f;              //1.5*2^23
+  static constexpr int   magicBits = 0x4b400000;
+  static constexpr float two_m = 8388608.0f;               //2^23
+  static constexpr int   two_mBits = 0x4b000000;
+  static constexpr float subScale = 33554432.0f;           //2^25
+  static constexpr int   subShift = 25;
+};
+
+//Rounds x to the nearest integer, returned
+//as a float (kd) and as an integer (k), from
+//the bits of x + 1.5*2^mantBits (|x| < 2^22)
+template<typename T>
+FORCE_INLINE void tRoundBits(const T x, T & kd, typename tFloatBits<T>::int_t & k)
+{
+  using B = tFloatBits<T>;
+  const T xm = x + B::magic;
+  std::memcpy(&k, &xm, sizeof(T));
+  k  = k - B::magicBits;
+  kd = xm - B::magic;
+};
+
+//The bits of a float, the special value
+//tests are integer compares of these as
+//floating compares may trap, which stops
+//the if-conversion/vectorisation
+template<typename T>
+FORCE_INLINE typename tFloatBits<T>::int_t tBitsOf(const T x)
+{
+  typename tFloatBits<T>::int_t bits;
+  std::memcpy(&bits, &x, sizeof(T));
+  return bits;
+};
+
+//All ones (true) or zero (false) bit mask
+template<typename I_t>
+FORCE_INLINE I_t tMask(const bool flag){return -I_t(flag);};
+
+//Replaces the bits of x by special where
+//the mask is set (integer only, no selects)
+template<typename T>
+FORCE_INLINE T tMaskedBits(const T x, const typename tFloatBits<T>::int_t special
+                                    , const typename tFloatBits<T>::int_t mask)
+{
+  typename tFloatBits<T>::int_t bits = (tBitsOf<T>(x) & ~mask) | (special & mask);
+  T y;
+  std::memcpy(&y, &bits, sizeof(T));
+  return y;
+};
+
+//a (true) or 0 (false), from the bit mask
+template<typename T>
+FORCE_INLINE T tFlagValue(const bool flag, const T a)
+{
+  return tMaskedBits<T>(T(0.0), tBitsOf<T>(a), tMask<typename tFloatBits<T>::int_t>(flag));
+};
+
+//2^k for k in the normal range
+template<typename T>
+FORCE_INLINE T tPow2Bits(const typename tFloatBits<T>::int_t k)
+{
+  using B = tFloatBits<T>;
+  using U_t = std::make_unsigned_t<typename B::int_t>;
+  typename B::int_t bits = typename B::int_t(U_t(k + B::bias) << B::mantBits);
+  T x;
+  std::memcpy(&x, &bits, sizeof(T));
+  return x;
+};
+
+// Batched exponential, x = k.ln2 + r
+template<typename T>
+FORCE_INLINE void tBatchExp(const T * __restrict__ x, T * __restrict__ y, const std::size_t n)
+{
+  using B = tFloatBits<T>;
+  using K = tExpConsts<std::is_same<T,float>::value>;
+  using I_t = typename B::int_t;
+  constexpr T inf = std::numeric_limits<T>::infinity();
+  const I_t infBits  = tBitsOf<T>(inf);
+  const I_t xMaxBits = tBitsOf<T>(T(K::xMax));
+  const I_t xMinBits = tBitsOf<T>(T(-K::xMin));
+
+  #pragma omp simd
+  for(std::size_t I=0; I<n; I++){
+    //Flags first (no short-circuits),
+    //so the selects are branch-free
+    const T p = x[I];
+    const I_t b = tBitsOf<T>(p), bAbs = b & B::absMask;
+    const bool isNaN = (bAbs > infBits);
+    const bool over  = (b > xMaxBits) & !isNaN;
+    const bool under = (b < 0) & (bAbs > xMinBits) & !isNaN;
+
+    //The kernel is evaluated for every p (out of
+    //range values give garbage which is replaced)
+    T kd;
+    I_t k;
+    tRoundBits<T>(p*T(K::invLn2), kd, k);
+    const T r  = (p - kd*T(K::ln2HI)) - kd*T(K::ln2LO);
+    const T z  = r*r;
+    const T c  = r - z*tHorner<K::nP>(z, K::P);
+    const I_t k1 = k/2;
+    const T expX = ((r*c)/(T(2.0) - c) + r + T(1.0))*tPow2Bits<T>(k1)*tPow2Bits<T>(k - k1);
+    const I_t mOver = tMask<I_t>(over), mNaN = tMask<I_t>(isNaN);
+    const I_t mAny  = mOver | mNaN | tMask<I_t>(under);
+    y[I] = tMaskedBits<T>(expX, (mOver & infBits) | (mNaN & b), mAny);
+  }
+};
+
+// Batched natural log, x = 2^e.f
+template<typename T>
+FORCE_INLINE void tBatchLog(const T * __restrict__ x, T * __restrict__ y, const std::size_t n)
+{
+  using B = tFloatBits<T>;
+  using K = tLogConsts<std::is_same<T,float>::value>;
+  using I_t = typename B::int_t;
+  constexpr T inf = std::numeric_limits<T>::infinity();
+  constexpr T nan = std::numeric_limits<T>::quiet_NaN();
+  const I_t infBits   = tBitsOf<T>(inf);
+  const I_t mInfBits  = tBitsOf<T>(-inf);
+  const I_t nanBits   = tBitsOf<T>(nan);
+  const I_t minBits   = tBitsOf<T>(std::numeric_limits<T>::min());
+  const I_t sqrt2Bits = tBitsOf<T>(T(1.41421356237309504880));
+
+  #pragma omp simd
+  for(std::size_t I=0; I<n; I++){
+    //Flags first (no short-circuits),
+    //so the selects are branch-free
+    const T p = x[I];
+    const I_t b = tBitsOf<T>(p), bAbs = b & B::absMask;
+    const bool tiny = (b < minBits), isZero = (bAbs == 0), isInf = (b == infBits);
+    const bool negOrNaN = ((b < 0) & !isZero) | (bAbs > infBits);
+    const T sub = tFlagValue<T>(tiny, T(B::subShift));
+    const T ps  = p*(tFlagValue<T>(tiny, B::subScale - T(1.0)) + T(1.0));
+
+    //Split the exponent and mantissa
+    I_t bits;
+    std::memcpy(&bits, &ps, sizeof(T));
+    I_t eBits = ((bits >> B::mantBits) & B::expMask) | B::two_mBits;
+    bits = (bits & B::mantMask) | (B::bias << B::mantBits);
+    T f, ed;
+    std::memcpy(&f, &bits, sizeof(T));
+    std::memcpy(&ed, &eBits, sizeof(T));
+    ed = ((ed - B::two_m) - T(B::bias)) - sub;
+    const bool big = (bits > sqrt2Bits);
+    f  = f*(T(1.0) - tFlagValue<T>(big, T(0.5)));
+    ed = ed + tFlagValue<T>(big, T(1.0));
+
+    //Kernel
+    const T s = (f - T(1.0))/(f + T(1.0));
+    const T z = s*s;
+    const T R = z*tHorner<K::nLg>(z, K::Lg);
+    const T logX = (s*(R + T(2.0)) + ed*T(K::ln2LO)) + ed*T(K::ln2HI);
+    const I_t mInf = tMask<I_t>(isInf), mZero = tMask<I_t>(isZero), mNaN = tMask<I_t>(negOrNaN);
+    const I_t special = (mInf & infBits) | (mZero & mInfBits) | (mNaN & nanBits);
+    y[I] = tMaskedBits<T>(logX, special, mInf | mZero | mNaN);
+  }
+};
+
+// Batched sin (cosine=false) and cos (cosine=true)
+// x = k.PI/2 + r and the quadrant selected, the
+// lanes past the Cody-Waite range (and NaN/inf)
+// are counted and recomputed by the scalar
+// function after the vector pass
+template<typename T, bool cosine>
+FORCE_INLINE void tBatchSinCos(const T * __restrict__ x, T * __restrict__ y, const std::size_t n)
+{
+  using B = tFloatBits<T>;
+  using K = tTrigConsts<std::is_same<T,float>::value>;
+  using I_t = typename B::int_t;
+  const I_t maxBits = tBitsOf<T>(T(K::maxCodyWaite));
+  std::size_t nFar=0;
+
+  #pragma omp simd reduction(+:nFar)
+  for(std::size_t I=0; I<n; I++){
+    const T p  = x[I];
+    nFar += ((tBitsOf<T>(p) & B::absMask) > maxBits);
+    T kd;
+    I_t k;
+    tRoundBits<T>(p*T(K::twoOverPI), kd, k);
+    const T r  = ((p - kd*T(K::pio2_1)) - kd*T(K::pio2_2)) - kd*T(K::pio2_3);
+    const I_t q = (k + (cosine? 1:0)) & 3;
+    const T s = tSinKernel<T>(r);
+    const T c = tCosKernel<T>(r);
+    const T v = (q & 1)? c:s;
+    y[I] = (q & 2)? -v:v;
+  }
+
+  //Out of range lanes
+  if(nFar == 0) return;
+  for(std::size_t I=0; I<n; I++){
+    if((tBitsOf<T>(x[I]) & B::absMask) > maxBits) y[I] = cosine? ::cos<T>(x[I]): ::sin<T>(x[I]);
+  }
+};
+
+//Functions with a branch-free batch
+//(for double and float)
+template<typename Primal> struct tBatchSimd{static constexpr bool value=false;};
+
+template<> struct tBatchSimd<tPrimal_exp>{
+  static constexpr bool value=true;
+  template<typename T> static FORCE_INLINE void eval(const T *x, T *y, const std::size_t n){tBatchExp<T>(x, y, n);};
+};
+
+template<> struct tBatchSimd<tPrimal_log>{
+  static constexpr bool value=true;
+  template<typename T> static FORCE_INLINE void eval(const T *x, T *y, const std::size_t n){tBatchLog<T>(x, y, n);};
+};
+
+template<> struct tBatchSimd<tPrimal_sin>{
+  static constexpr bool value=true;
+  template<typename T> static FORCE_INLINE void eval(const T *x, T *y, const std::size_t n){tBatchSinCos<T,false>(x, y, n);};
+};
+
+template<> struct tBatchSimd<tPrimal_cos>{
+  static constexpr bool value=true;
+  template<typename T> static FORCE_INLINE void eval(const T *x, T *y, const std::size_t n){tBatchSinCos<T,true>(x, y, n);};
+};
+
+//Evaluate a batch, either the branch-free
+//loop or point by point
+template<typename Primal, typename T>
+FORCE_INLINE void tBatchEval(const T * __restrict__ x, T * __restrict__ y, const std::size_t n)
+{
+  if constexpr(tBatchSimd<Primal>::value and std::is_floating_point<T>::value){
+    tBatchSimd<Primal>::template eval<T>(x, y, n);
+  }else{
+    for(std::size_t I=0; I<n; I++) y[I] = Primal::eval(x[I]);
+  }
+};
+
+// Applies any function (e.g. a material law)
+// to a batch, point by point
+template<typename Tin, typename T, typename Func>
+FORCE_INLINE void tBatchApply(const tSpan<Tin> x, const tSpan<T> y, Func func)
+{
+  const std::size_t n = (x.size() < y.size())? x.size():y.size();
+  const Tin * __restrict__ xp = x.data();
+  T * __restrict__ yp = y.data();
+  for(std::size_t I=0; I<n; I++) yp[I] = func(xp[I]);
+};
+
+/*****************************************\
+!
+!  The batched entry points
+!
+\*****************************************/
+#define TBATCH_FUNC1(FUNC, PRIMAL)                                                      \
+template<typename Tin, typename T                                                       \
+        , typename = std::enable_if_t<std::is_same<std::remove_const_t<Tin>,T>::value>> \
+FORCE_INLINE void FUNC(const tSpan<Tin> x, const tSpan<T> y)                            \
+{                                                                                       \
+  const std::size_t n = (x.size() < y.size())? x.size():y.size();                       \
+  tBatchEval<PRIMAL,T>(x.data(), y.data(), n);                                          \
+};
+
+//Exponential and log functions
+TBATCH_FUNC1(exp,   tPrimal_exp)
+TBATCH_FUNC1(log,   tPrimal_log)
+TBATCH_FUNC1(log10, tPrimal_log10)
+TBATCH_FUNC1(log2,  tPrimal_log2)
+TBATCH_FUNC1(exp2,  tPrimal_exp2)
+TBATCH_FUNC1(expm1, tPrimal_expm1)
+TBATCH_FUNC1(log1p, tPrimal_log1p)
+
+//Power functions
+TBATCH_FUNC1(sqrt,  tPrimal_sqrt)
+TBATCH_FUNC1(cbrt,  tPrimal_cbrt)
+
+//Trigonometric functions
+TBATCH_FUNC1(sin,   tPrimal_sin)
+TBATCH_FUNC1(cos,   tPrimal_cos)
+TBATCH_FUNC1(tan,   tPrimal_tan)
+TBATCH_FUNC1(asin,  tPrimal_asin)
+TBATCH_FUNC1(acos,  tPrimal_acos)
+TBATCH_FUNC1(atan,  tPrimal_atan)
+
+//Hyperbolic functions
+TBATCH_FUNC1(sinh,  tPrimal_sinh)
+TBATCH_FUNC1(cosh,  tPrimal_cosh)
+TBATCH_FUNC1(tanh,  tPrimal_tanh)
+TBATCH_FUNC1(asinh, tPrimal_asinh)
+TBATCH_FUNC1(acosh, tPrimal_acosh)
+TBATCH_FUNC1(atanh, tPrimal_atanh)
+
+//Error and other functions
+TBATCH_FUNC1(erf,   tPrimal_erf)
+TBATCH_FUNC1(erfc,  tPrimal_erfc)
+TBATCH_FUNC1(abs,   tPrimal_fabs)
+TBATCH_FUNC1(fabs,  tPrimal_fabs)
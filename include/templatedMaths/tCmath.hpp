@@ -4,5 +4,7 @@
 #include "tPowFuncs.hpp"        //Done
 #include "tHypFuncs.hpp"        //Done
 #include "tErfGammaFuncs.hpp"   //
-#include "tTrigFuncs.hpp"       //Done (Need ATan2)
+#include "tTrigFuncs.hpp"       //Done
 #include "tOtherFuncs.hpp"      //Done
+#include "tDualFuncs.hpp"       //Analytic dual overloads
+#include "tBatchFuncs.hpp"      //Batched evaluation
@@ -0,0 +1,609 @@
+#pragma once
+#include <cmath>
+#include "../UtilityObjects/macros.hpp"
+#include "../templatedMathObjs/dualNumber.hpp"
+#include "../templatedMathObjs/dualVecNumber.hpp"
+#include "../templatedMathObjs/dualSimdNumber.hpp"
+#include "../templatedMathObjs/dualHessNumber.hpp"
+#include "../templatedMathObjs/tapeNumber.hpp"
+#include "tPowFuncs.hpp"
+
+/*****************************************\
+!
+!  Analytic chain-rule specialisations of
+!  the templated maths for the dual types
+!
+!  The generic templates push every
+!  iteration of their (iterative) kernel
+!  through the dual arithmetic, instead
+!  these overloads evaluate the primal
+!  with the native function and apply
+!  the derivative analytically:
+!   f(a) = (f(a.val), f'(a.val)*a.grad)
+!  For nested duals (a.val is a dual) the
+!  rule is evaluated in the value type,
+!  which recurses into these overloads.
+!
+!  Each rule gives f(x), f'(x) and f''(x)
+!  (the last only used by the Hessian-lane
+!  numbers)
+!
+\*****************************************/
+//Primal function calls, the native <cmath>
+//function for double/float and the overloads
+//below (found by ADL) for nested dual values
+#define TDUAL_PRIMAL(FUNC)                                        \
+struct tPrimal_##FUNC{                                            \
+  template<typename T>                                            \
+  static FORCE_INLINE T eval(const T & x){using std::FUNC; return FUNC(x);}; \
+};
+
+TDUAL_PRIMAL(exp)   TDUAL_PRIMAL(log)   TDUAL_PRIMAL(log10) TDUAL_PRIMAL(log2)
+TDUAL_PRIMAL(exp2)  TDUAL_PRIMAL(expm1) TDUAL_PRIMAL(log1p) TDUAL_PRIMAL(sqrt)
+TDUAL_PRIMAL(cbrt)  TDUAL_PRIMAL(sin)   TDUAL_PRIMAL(cos)   TDUAL_PRIMAL(tan)
+TDUAL_PRIMAL(asin)  TDUAL_PRIMAL(acos)  TDUAL_PRIMAL(atan)  TDUAL_PRIMAL(sinh)
+TDUAL_PRIMAL(cosh)  TDUAL_PRIMAL(tanh)  TDUAL_PRIMAL(asinh) TDUAL_PRIMAL(acosh)
+TDUAL_PRIMAL(atanh) TDUAL_PRIMAL(erf)   TDUAL_PRIMAL(erfc)  TDUAL_PRIMAL(fabs)
+
+//The rules f, f' (given f) and f'' (given f and f')
+//Exponential and log functions
+struct tExpRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_exp::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return fx;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T &){return fx;};
+};
+
+struct tLogRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_log::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/x;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T &, const T & dfx){return -1.0*dfx*dfx;};
+};
+
+struct tLog10Rule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_log10::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 0.43429448190325182765/x;};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -1.0*dfx/x;};
+};
+
+struct tLog2Rule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_log2::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.44269504088896340736/x;};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -1.0*dfx/x;};
+};
+
+struct tExp2Rule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_exp2::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return 0.69314718055994530942*fx;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T &, const T & dfx){return 0.69314718055994530942*dfx;};
+};
+
+struct tExpm1Rule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_expm1::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return fx + 1.0;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T &, const T & dfx){return dfx;};
+};
+
+struct tLog1pRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_log1p::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/(x + 1.0);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T &, const T & dfx){return -1.0*dfx*dfx;};
+};
+
+//Power functions
+struct tSqrtRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_sqrt::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return 0.5/fx;};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -0.5*dfx/x;};
+};
+
+struct tCbrtRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_cbrt::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return (1.0/3.0)/(fx*fx);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return (-2.0/3.0)*dfx/x;};
+};
+
+//Trigonometric functions
+struct tSinRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_sin::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return tPrimal_cos::eval(x);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T &){return -1.0*fx;};
+};
+
+struct tCosRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_cos::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return -1.0*tPrimal_sin::eval(x);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T &){return -1.0*fx;};
+};
+
+struct tTanRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_tan::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return fx*fx + 1.0;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T & dfx){return 2.0*fx*dfx;};
+};
+
+struct tAsinRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_asin::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/tPrimal_sqrt::eval(1.0 - x*x);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return x*dfx*dfx*dfx;};
+};
+
+struct tAcosRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_acos::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return -1.0/tPrimal_sqrt::eval(1.0 - x*x);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return x*dfx*dfx*dfx;};
+};
+
+struct tAtanRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_atan::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/(x*x + 1.0);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -2.0*x*dfx*dfx;};
+};
+
+//Hyperbolic functions
+struct tSinhRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_sinh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return tPrimal_cosh::eval(x);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T &){return fx;};
+};
+
+struct tCoshRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_cosh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return tPrimal_sinh::eval(x);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T &){return fx;};
+};
+
+struct tTanhRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_tanh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T &, const T & fx){return 1.0 - fx*fx;};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T & fx, const T & dfx){return -2.0*fx*dfx;};
+};
+
+struct tAsinhRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_asinh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/tPrimal_sqrt::eval(x*x + 1.0);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -1.0*x*dfx*dfx*dfx;};
+};
+
+struct tAcoshRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_acosh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/tPrimal_sqrt::eval(x*x - 1.0);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -1.0*x*dfx*dfx*dfx;};
+};
+
+struct tAtanhRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_atanh::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.0/(1.0 - x*x);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return 2.0*x*dfx*dfx;};
+};
+
+//Error and other functions
+struct tErfRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_erf::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return 1.12837916709551257390*tPrimal_exp::eval(-1.0*x*x);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -2.0*x*dfx;};
+};
+
+struct tErfcRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_erfc::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return -1.12837916709551257390*tPrimal_exp::eval(-1.0*x*x);};
+  template<typename T> static FORCE_INLINE T d2f(const T & x, const T &, const T & dfx){return -2.0*x*dfx;};
+};
+
+struct tFabsRule{
+  template<typename T> static FORCE_INLINE T f(const T & x){return tPrimal_fabs::eval(x);};
+  template<typename T> static FORCE_INLINE T df(const T & x, const T &){return (x < 0.0)? T(-1.0):T(1.0);};
+  template<typename T> static FORCE_INLINE T d2f(const T &, const T &, const T &){return T(0.0);};
+};
+
+/*****************************************\
+!
+!  First order chain rule of each of the
+!  dual types:
+!   f(a) = (f0, f1*a.grad)
+!
+\*****************************************/
+template<typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> dualChain(const dualNumber<v_t,g_t> & a, const v_t & f0, const v_t & f1)
+{
+  return dualNumber<v_t,g_t>(f0, f1*a.grad);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualVecNumber<v_t,N> dualChain(const dualVecNumber<v_t,N> & a, const v_t & f0, const v_t & f1)
+{
+  dualVecNumber<v_t,N> newVal(f0);
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) newVal.grad[I] = f1*a.grad[I];
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualSimdNumber<v_t,N> dualChain(const dualSimdNumber<v_t,N> & a, const v_t & f0, const v_t & f1)
+{
+  dualSimdNumber<v_t,N> newVal(f0);
+  dualSimdLanes<v_t,N>::scale(newVal.grad, f1, a.grad);
+  return newVal;
+};
+
+template<typename v_t>
+inline tapeNumber<v_t> dualChain(const tapeNumber<v_t> & a, const v_t & f0, const v_t & f1)
+{
+  return tapeUnary<v_t>(a, f0, f1);
+};
+
+//Apply a rule to a dual type
+template<typename Rule, typename dual_t>
+FORCE_INLINE dual_t dualApply(const dual_t & a)
+{
+  const auto f0 = Rule::f(a.val);
+  return dualChain(a, f0, Rule::df(a.val, f0));
+};
+
+//The Hessian-lane numbers also need f''
+template<typename Rule, typename v_t, unsigned N>
+FORCE_INLINE dualHessNumber<v_t,N> dualApply(const dualHessNumber<v_t,N> & a)
+{
+  const v_t f0 = Rule::f(a.val);
+  const v_t f1 = Rule::df(a.val, f0);
+  return hessChain<v_t,N>(a, f0, f1, Rule::d2f(a.val, f0, f1));
+};
+
+/*****************************************\
+!
+!  The overloads, these are more
+!  specialised than the generic templates
+!  so they are picked for every dual type
+!
+\*****************************************/
+#define TDUAL_FUNC1(FUNC, RULE)                                                                        \
+template<typename v_t, typename g_t>                                                                   \
+FORCE_INLINE dualNumber<v_t,g_t> FUNC(const dualNumber<v_t,g_t> & a){return dualApply<RULE>(a);};      \
+template<typename v_t, unsigned N>                                                                     \
+FORCE_INLINE dualVecNumber<v_t,N> FUNC(const dualVecNumber<v_t,N> & a){return dualApply<RULE>(a);};    \
+template<typename v_t, unsigned N>                                                                     \
+FORCE_INLINE dualSimdNumber<v_t,N> FUNC(const dualSimdNumber<v_t,N> & a){return dualApply<RULE>(a);};  \
+template<typename v_t, unsigned N>                                                                     \
+FORCE_INLINE dualHessNumber<v_t,N> FUNC(const dualHessNumber<v_t,N> & a){return dualApply<RULE>(a);};  \
+template<typename v_t>                                                                                 \
+inline tapeNumber<v_t> FUNC(const tapeNumber<v_t> & a){return dualApply<RULE>(a);};
+
+//Exponential and log functions
+TDUAL_FUNC1(exp,   tExpRule)
+TDUAL_FUNC1(log,   tLogRule)
+TDUAL_FUNC1(log10, tLog10Rule)
+TDUAL_FUNC1(log2,  tLog2Rule)
+TDUAL_FUNC1(logb,  tLog2Rule)   //logb is the binary log in tCmath
+TDUAL_FUNC1(exp2,  tExp2Rule)
+TDUAL_FUNC1(expm1, tExpm1Rule)
+TDUAL_FUNC1(log1p, tLog1pRule)
+
+//Power functions
+TDUAL_FUNC1(sqrt,  tSqrtRule)
+TDUAL_FUNC1(cbrt,  tCbrtRule)
+
+//Trigonometric functions
+TDUAL_FUNC1(sin,   tSinRule)
+TDUAL_FUNC1(cos,   tCosRule)
+TDUAL_FUNC1(tan,   tTanRule)
+TDUAL_FUNC1(asin,  tAsinRule)
+TDUAL_FUNC1(acos,  tAcosRule)
+TDUAL_FUNC1(atan,  tAtanRule)
+
+//Hyperbolic functions
+TDUAL_FUNC1(sinh,  tSinhRule)
+TDUAL_FUNC1(cosh,  tCoshRule)
+TDUAL_FUNC1(tanh,  tTanhRule)
+TDUAL_FUNC1(asinh, tAsinhRule)
+TDUAL_FUNC1(acosh, tAcoshRule)
+TDUAL_FUNC1(atanh, tAtanhRule)
+
+//Error and other functions
+TDUAL_FUNC1(erf,   tErfRule)
+TDUAL_FUNC1(erfc,  tErfcRule)
+TDUAL_FUNC1(abs,   tFabsRule)
+TDUAL_FUNC1(fabs,  tFabsRule)
+
+/*****************************************\
+!
+!  Two argument functions
+!   x^p  : p.x^(p-1), p.(p-1).x^(p-2)
+!   x^y  : exp(y.log(x))
+!   hypot: sqrt(x^2 + y^2)
+!
+\*****************************************/
+//x^p for a constant exponent
+template<typename v_t>
+FORCE_INLINE void tPowConstRule(const v_t & x, const double p, v_t & f0, v_t & f1, v_t & f2)
+{
+  using std::pow;
+  f0 = pow(x, v_t(p));
+  f1 = p*pow(x, v_t(p - 1.0));
+  f2 = (p*(p - 1.0))*pow(x, v_t(p - 2.0));
+};
+
+template<typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> pow(const dualNumber<v_t,g_t> & x, const double p)
+{
+  v_t f0, f1, f2;
+  tPowConstRule<v_t>(x.val, p, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualVecNumber<v_t,N> pow(const dualVecNumber<v_t,N> & x, const double p)
+{
+  v_t f0, f1, f2;
+  tPowConstRule<v_t>(x.val, p, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualSimdNumber<v_t,N> pow(const dualSimdNumber<v_t,N> & x, const double p)
+{
+  v_t f0, f1, f2;
+  tPowConstRule<v_t>(x.val, p, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualHessNumber<v_t,N> pow(const dualHessNumber<v_t,N> & x, const double p)
+{
+  v_t f0, f1, f2;
+  tPowConstRule<v_t>(x.val, p, f0, f1, f2);
+  return hessChain<v_t,N>(x, f0, f1, f2);
+};
+
+template<typename v_t>
+inline tapeNumber<v_t> pow(const tapeNumber<v_t> & x, const double p)
+{
+  v_t f0, f1, f2;
+  tPowConstRule<v_t>(x.val, p, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+//x^y with both dual, d(x^y) = y.x^(y-1).dx + x^y.log(x).dy
+template<typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> pow(const dualNumber<v_t,g_t> & x, const dualNumber<v_t,g_t> & y)
+{
+  using std::pow;
+  const v_t f0 = pow(x.val, y.val);
+  const v_t dfdx = y.val*pow(x.val, y.val - 1.0);
+  const v_t dfdy = f0*tPrimal_log::eval(x.val);
+  return dualNumber<v_t,g_t>(f0, dfdx*x.grad + dfdy*y.grad);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualVecNumber<v_t,N> pow(const dualVecNumber<v_t,N> & x, const dualVecNumber<v_t,N> & y)
+{
+  using std::pow;
+  dualVecNumber<v_t,N> newVal(pow(x.val, y.val));
+  const v_t dfdx = y.val*pow(x.val, y.val - 1.0);
+  const v_t dfdy = newVal.val*tPrimal_log::eval(x.val);
+  #pragma unroll
+  for(unsigned I=0; I<N; I++) newVal.grad[I] = dfdx*x.grad[I] + dfdy*y.grad[I];
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualSimdNumber<v_t,N> pow(const dualSimdNumber<v_t,N> & x, const dualSimdNumber<v_t,N> & y)
+{
+  using std::pow;
+  dualSimdNumber<v_t,N> newVal(pow(x.val, y.val));
+  const v_t dfdx = y.val*pow(x.val, y.val - 1.0);
+  const v_t dfdy = newVal.val*tPrimal_log::eval(x.val);
+  dualSimdLanes<v_t,N>::axpby(newVal.grad, dfdx, x.grad, dfdy, y.grad);
+  return newVal;
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualHessNumber<v_t,N> pow(const dualHessNumber<v_t,N> & x, const dualHessNumber<v_t,N> & y)
+{
+  return exp(y*log(x));
+};
+
+template<typename v_t>
+inline tapeNumber<v_t> pow(const tapeNumber<v_t> & x, const tapeNumber<v_t> & y)
+{
+  using std::pow;
+  const v_t f0 = pow(x.val, y.val);
+  return tapeBinary<v_t>(x, y, f0, y.val*pow(x.val, y.val - 1.0), f0*tPrimal_log::eval(x.val));
+};
+
+/*****************************************\
+!
+!  Integer and rational exponents, the
+!  value and derivatives come from one
+!  multiplication chain of x (or of its
+!  root) so no exp/log is needed:
+!   x^N    : N.x^(N-1), N.(N-1).x^(N-2)
+!   x^(P/Q): r = x^(1/Q), (P/Q).r^(P-Q)
+!
+\*****************************************/
+//x^N for a compile time N
+template<int N, typename v_t>
+FORCE_INLINE void tPowNRule(const v_t & x, v_t & f0, v_t & f1, v_t & f2)
+{
+  if constexpr(N == 0){
+    f0 = v_t(1.0); f1 = v_t(0.0); f2 = v_t(0.0);
+  }else if constexpr(N == 1){
+    f0 = x; f1 = v_t(1.0); f2 = v_t(0.0);
+  }else{
+    const v_t xPowN1 = pow<N-1>(x);
+    f0 = xPowN1*x;
+    f1 = double(N)*xPowN1;
+    f2 = double(N*(N-1))*pow<N-2>(x);
+  }
+};
+
+//x^(P/Q) for compile time P and Q
+template<int P, int Q, typename v_t>
+FORCE_INLINE void tPowPQRule(const v_t & x, v_t & f0, v_t & f1, v_t & f2)
+{
+  constexpr int D = std::gcd(P, Q);
+  constexpr int Pr = P/D, Qr = Q/D;
+  if constexpr(Qr == 1){
+    tPowNRule<Pr,v_t>(x, f0, f1, f2);
+  }else{
+    constexpr double p = double(Pr)/double(Qr);
+    const v_t r = tRoot<Qr>(x);
+    f0 = pow<Pr>(r);
+    f1 = p*pow<Pr-Qr>(r);
+    f2 = (p*(p - 1.0))*pow<Pr-2*Qr>(r);
+  }
+};
+
+//x^n for a run time n
+template<typename v_t>
+FORCE_INLINE void tPowIntRule(const v_t & x, const int n, v_t & f0, v_t & f1, v_t & f2)
+{
+  if(n == 0){
+    f0 = v_t(1.0); f1 = v_t(0.0); f2 = v_t(0.0);
+  }else if(n == 1){
+    f0 = x; f1 = v_t(1.0); f2 = v_t(0.0);
+  }else{
+    const v_t xPowN2 = pow(x, n-2);
+    const v_t xPowN1 = xPowN2*x;
+    f0 = xPowN1*x;
+    f1 = double(n)*xPowN1;
+    f2 = (double(n)*double(n-1))*xPowN2;
+  }
+};
+
+//pow<N>(x)
+template<int N, typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> pow(const dualNumber<v_t,g_t> & x)
+{
+  v_t f0, f1, f2;
+  tPowNRule<N,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int N, typename v_t, unsigned M>
+FORCE_INLINE dualVecNumber<v_t,M> pow(const dualVecNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowNRule<N,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int N, typename v_t, unsigned M>
+FORCE_INLINE dualSimdNumber<v_t,M> pow(const dualSimdNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowNRule<N,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int N, typename v_t, unsigned M>
+FORCE_INLINE dualHessNumber<v_t,M> pow(const dualHessNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowNRule<N,v_t>(x.val, f0, f1, f2);
+  return hessChain<v_t,M>(x, f0, f1, f2);
+};
+
+template<int N, typename v_t>
+inline tapeNumber<v_t> pow(const tapeNumber<v_t> & x)
+{
+  v_t f0, f1, f2;
+  tPowNRule<N,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+//pow<P,Q>(x)
+template<int P, int Q, typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> pow(const dualNumber<v_t,g_t> & x)
+{
+  v_t f0, f1, f2;
+  tPowPQRule<P,Q,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int P, int Q, typename v_t, unsigned M>
+FORCE_INLINE dualVecNumber<v_t,M> pow(const dualVecNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowPQRule<P,Q,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int P, int Q, typename v_t, unsigned M>
+FORCE_INLINE dualSimdNumber<v_t,M> pow(const dualSimdNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowPQRule<P,Q,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<int P, int Q, typename v_t, unsigned M>
+FORCE_INLINE dualHessNumber<v_t,M> pow(const dualHessNumber<v_t,M> & x)
+{
+  v_t f0, f1, f2;
+  tPowPQRule<P,Q,v_t>(x.val, f0, f1, f2);
+  return hessChain<v_t,M>(x, f0, f1, f2);
+};
+
+template<int P, int Q, typename v_t>
+inline tapeNumber<v_t> pow(const tapeNumber<v_t> & x)
+{
+  v_t f0, f1, f2;
+  tPowPQRule<P,Q,v_t>(x.val, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+//pow(x,n) for an integer n
+template<typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> pow(const dualNumber<v_t,g_t> & x, const int n)
+{
+  v_t f0, f1, f2;
+  tPowIntRule<v_t>(x.val, n, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualVecNumber<v_t,N> pow(const dualVecNumber<v_t,N> & x, const int n)
+{
+  v_t f0, f1, f2;
+  tPowIntRule<v_t>(x.val, n, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualSimdNumber<v_t,N> pow(const dualSimdNumber<v_t,N> & x, const int n)
+{
+  v_t f0, f1, f2;
+  tPowIntRule<v_t>(x.val, n, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualHessNumber<v_t,N> pow(const dualHessNumber<v_t,N> & x, const int n)
+{
+  v_t f0, f1, f2;
+  tPowIntRule<v_t>(x.val, n, f0, f1, f2);
+  return hessChain<v_t,N>(x, f0, f1, f2);
+};
+
+template<typename v_t>
+inline tapeNumber<v_t> pow(const tapeNumber<v_t> & x, const int n)
+{
+  v_t f0, f1, f2;
+  tPowIntRule<v_t>(x.val, n, f0, f1, f2);
+  return dualChain(x, f0, f1);
+};
+
+//hypot, through the sqrt overloads
+template<typename v_t, typename g_t>
+FORCE_INLINE dualNumber<v_t,g_t> hypot(const dualNumber<v_t,g_t> & x, const dualNumber<v_t,g_t> & y){return sqrt(x*x + y*y);};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualVecNumber<v_t,N> hypot(const dualVecNumber<v_t,N> & x, const dualVecNumber<v_t,N> & y){return sqrt(x*x + y*y);};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualSimdNumber<v_t,N> hypot(const dualSimdNumber<v_t,N> & x, const dualSimdNumber<v_t,N> & y){return sqrt(x*x + y*y);};
+
+template<typename v_t, unsigned N>
+FORCE_INLINE dualHessNumber<v_t,N> hypot(const dualHessNumber<v_t,N> & x, const dualHessNumber<v_t,N> & y){return sqrt(x*x + y*y);};
+
+template<typename v_t>
+inline tapeNumber<v_t> hypot(const tapeNumber<v_t> & x, const tapeNumber<v_t> & y){return sqrt(x*x + y*y);};
@@ -1,89 +1,243 @@
 #pragma once
+#include <cstring>
+#include <limits>
 #include "../UtilityObjects/macros.hpp"
 
-// Returns the exponential
-// of a number
+/*****************************************\
+!
+!  Range reduction helpers, these act on
+!  the primal value only so the reduction
+!  is constant time (no loops/iterations)
+!  and the polynomial kernels carry the
+!  derivatives for the dual types
+!
+\*****************************************/
+// Returns 2^k as a double
+// (0 and inf outside the range)
+FORCE_INLINE double tPow2i(const int k)
+{
+  if(k >  1023) return std::numeric_limits<double>::infinity();
+  if(k < -1022) return 0.0;
+  UINT64 bits = UINT64(k + 1023) << 52;
+  double x;
+  std::memcpy(&x, &bits, sizeof(double));
+  return x;
+};
+
+// Returns x*2^k, in two factors
+// so subnormal/large k are fine
 template<typename Number>
-FORCE_INLINE Number exp(const Number x)
+FORCE_INLINE Number tLdexp(const Number & x, const int k)
 {
-  Number bigNum(33554432.0), one(1.0), xCopy(x);
-  Number expX = one + (xCopy/bigNum);
+  using S = tScalarType<Number>;
+  const int k1 = k/2;
+  return (x*S(tPow2i(k1)))*S(tPow2i(k - k1));
+};
 
-  #pragma unroll
-  for(unsigned I=0; I<25; I++) expX = expX*expX; // m=2^24
-  return expX;
+// Returns the nearest integer
+// (round half away from zero)
+FORCE_INLINE double tRoundNearest(const double x)
+{
+  return double(INT64( (x < 0.0)? (x - 0.5):(x + 0.5) ));
 };
 
+// Returns the binary exponent (e) of a
+// positive normal/subnormal x such that
+// x*2^-e is in [sqrt(1/2), sqrt(2))
+FORCE_INLINE int tExponentSqrt2(double x)
+{
+  int shift = 0;
+  if(x < 2.2250738585072014e-308){x = x*18014398509481984.0; shift = 54;}
+  UINT64 bits;
+  std::memcpy(&bits, &x, sizeof(double));
+  int e = int((bits >> 52) & 0x7ff) - 1023;
+  bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+  std::memcpy(&x, &bits, sizeof(double));
+  if(x > 1.41421356237309504880) e = e + 1;
+  return e - shift;
+};
 
-// Returns the natural log of a 
-// number using 10 iterations
-// of Halley's method
+// Evaluates the polynomial
+// c[0] + z*(c[1] + ... z*c[n-1])
+// with Horner's scheme (n >= 2)
+template<unsigned n, typename Number, unsigned nMax>
+FORCE_INLINE Number tHorner(const Number & z, const double (&c)[nMax])
+{
+  static_assert((n >= 2) and (n <= nMax), "tHorner: bad polynomial order");
+  using S = tScalarType<Number>;
+  Number p = z*S(c[n-1]) + S(c[n-2]);
+  #pragma unroll
+  for(int I=int(n)-3; I>=0; I--) p = p*z + S(c[I]);
+  return p;
+};
+
+// Single precision numbers use
+// shorter polynomials
 template<typename Number>
+constexpr bool tIsSingle = std::is_same<tScalarType<Number>,float>::value;
+
+
+// The exp kernel constants, shared by
+// the scalar and batched kernels
+template<bool single>
+struct tExpConsts{
+  static constexpr double ln2HI = single? 6.9313812256e-01 : 6.93147180369123816490e-01;
+  static constexpr double ln2LO = single? 9.0580006145e-06 : 1.90821492927058770002e-10;
+  static constexpr double invLn2=1.44269504088896338700e+00;
+  static constexpr double xMax = single? 88.72283935546875   : 709.782712893383973;
+  static constexpr double xMin = single? -103.97208404541015 : -745.133219101941108;
+  static constexpr unsigned nP = single? 3:5;
+  static constexpr double P[5]={ 1.66666666666666019037e-01, -2.77777777770155933842e-03
+                               , 6.61375632143793436117e-05, -1.65339022054652515390e-06
+                               , 4.13813679705723846039e-08};
+};
+
+// The log kernel constants, shared by
+// the scalar and batched kernels
+template<bool single>
+struct tLogConsts{
+  static constexpr double ln2HI=6.93147180369123816490e-01, ln2LO=1.90821492927058770002e-10;
+  static constexpr unsigned nLg = single? 4:7;
+  static constexpr double Lg[7]={ 6.666666666666735130e-01, 3.999999999940941908e-01
+                                , 2.857142874366239149e-01, 2.222219843214978396e-01
+                                , 1.818357216161805012e-01, 1.531383769920937332e-01
+                                , 1.479819860511658591e-01};
+};
+
+
+// Returns the exponential
+// of a number, x = k.ln2 + r
+// (ln2 split so k.ln2HI is exact)
+// with |r| <= ln2/2 and a minimax
+// (rational) kernel for exp(r)
+template<typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number exp(const Number x)
+{
+  using S = tScalarType<Number>;
+  using K = tExpConsts<tIsSingle<Number>>;
+
+  //Out of range values
+  const double p = primalValue(x);
+  if(p != p)  return x;
+  if(p > K::xMax) return Number(S(std::numeric_limits<double>::infinity()));
+  if(p < K::xMin) return Number(S(0.0));
+
+  //Reduce and evaluate the kernel
+  const double k = tRoundNearest(p*K::invLn2);
+  Number r = x - S(k*K::ln2HI);
+  r = r - S(k*K::ln2LO);
+  Number z = r*r;
+  Number c = r - z*tHorner<K::nP>(z, K::P);
+  Number expR = (r*c)/(S(2.0) - c) + r + S(1.0);
+  return tLdexp(expR, int(k));
+};
+
+
+// Returns the natural log of a number
+// x = 2^e.f with f in [sqrt(1/2),sqrt(2))
+// log(f) = 2.atanh(s), s=(f-1)/(f+1)
+// with a minimax kernel in s^2
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number log(const Number x)
 {
-  //B = log(x) => x = exp(B)
-  Number B(0.00), expB(0.00), const2(2.0);
-  Number xPb(0.00), xMb(0.00);
+  using S = tScalarType<Number>;
+  using K = tLogConsts<tIsSingle<Number>>;
 
-  //Use iterative formula x-exp(b) = 0
-  //and solve with 5 iterations of
-  //Halley's Method
-  #pragma unroll
-  for(unsigned I=0; I<10; I++){
-    expB =  exp<Number>(B);
-    xPb  = (expB + x);
-    xMb  = (expB - x);
-    B = B - const2*(xMb/xPb);
-  }
-  return B;
+  //Out of range values
+  const double p = primalValue(x);
+  if(p != p)  return x;
+  if(p < 0.0) return Number(S(std::numeric_limits<double>::quiet_NaN()));
+  if(p == 0.0) return Number(S(-std::numeric_limits<double>::infinity()));
+  if(p == std::numeric_limits<double>::infinity()) return x;
+
+  //Reduce and evaluate the kernel
+  const int e = tExponentSqrt2(p);
+  Number f = tLdexp(x, -e);
+  Number s = (f - S(1.0))/(f + S(1.0));
+  Number z = s*s;
+  Number R = z*tHorner<K::nLg>(z, K::Lg);
+  Number logF = s*(R + S(2.0));
+  return (logF + S(double(e)*K::ln2LO)) + S(double(e)*K::ln2HI);
 };
 
 
 // Returns the common log
 // of a number (base 10)
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number log10(const Number x)
 {
-  Number ln10 = log<Number>(Number(10.0));
-  Number lnX = log<Number>(x);
-  return lnX/ln10;
+  using S = tScalarType<Number>;
+  return log<Number>(x)*S(0.43429448190325182765);
 };
 
 
 // Returns the exponential function
 // base 2
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number exp2(const Number x)
 {
-  Number ln2 = log<Number>(Number(2.0));
-  return exp<Number>(x*ln2);
+  using S = tScalarType<Number>;
+  return exp<Number>(x*S(0.69314718055994530942));
 };
 
 
 // Returns the exponential function
-// minus 1
-template<typename Number>
+// minus 1, x = k.ln2 + r as for exp with
+// exp(r) - 1 = r + r.c/(2 - c) from the
+// same kernel (no cancellation for small
+// |x|) and expm1(x) = 2^k.(exp(r) - 1)
+// + (2^k - 1)
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number expm1(const Number x)
 {
-  Number one(1.0);
-  return exp<Number>(x) - one;
+  using S = tScalarType<Number>;
+  using K = tExpConsts<tIsSingle<Number>>;
+
+  //Out of range values
+  const double p = primalValue(x);
+  if(p != p)  return x;
+  if(p > K::xMax) return Number(S(std::numeric_limits<double>::infinity()));
+  if(p < -40.0)   return Number(S(-1.0));
+
+  //Reduce and evaluate the kernel
+  const double k = tRoundNearest(p*K::invLn2);
+  Number rHi = x - S(k*K::ln2HI);
+  Number r = rHi - S(k*K::ln2LO);
+  Number rErr = (rHi - r) - S(k*K::ln2LO);
+  Number z = r*r;
+  Number c = r - z*tHorner<K::nP>(z, K::P);
+
+  //The rounding error of r is kept
+  //(d/dr expm1(r) = 1 + expm1(r))
+  Number cR = (r*c)/(S(2.0) - c);
+  cR = cR + rErr*(S(1.0) + r);
+  if(k == 0.0) return cR + r;
+  if(k > 56.0) return tLdexp(cR + r + S(1.0), int(k)) - S(1.0);
+
+  //2^k.r + (2^k - 1) first (exact for |k| = 1),
+  //the small correction is added last, for
+  //k > 1 2^k.((1 - 2^-k) + r + cR) as for exp
+  //(2^-k is moved to r once 1 - 2^-k rounds)
+  constexpr double kExact = std::numeric_limits<S>::digits;
+  if(k >= kExact) return tLdexp(S(1.0) + ((r + cR) - S(tPow2i(-int(k)))), int(k));
+  if(k > 1.0)     return tLdexp(S(1.0 - tPow2i(-int(k))) + (r + cR), int(k));
+  return (tLdexp(r, int(k)) + S(tPow2i(int(k)) - 1.0)) + tLdexp(cR, int(k));
 };
 
 
 // Returns the binary log
 // of a number (base 2)
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number log2(const Number x)
 {
-  Number ln2 = log<Number>(Number(2.0));
-  Number lnX = log<Number>(x);
-  return lnX/ln2;
+  using S = tScalarType<Number>;
+  return log<Number>(x)*S(1.44269504088896340736);
 };
 
 
 // Returns the binary log
 // of a number (base 2)
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number logb(const Number x)
 {
   return  log2<Number>(x);
@@ -92,7 +246,7 @@ FORCE_INLINE Number logb(const Number x)
 
 // Returns the value from significand
 // and exponent
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number ldexp(const Number x, const Number y)
 {
   return  x*exp2<Number>(y);
@@ -100,18 +254,18 @@ FORCE_INLINE Number ldexp(const Number x, const Number y)
 
 
 // Returns the value of the
-// natural log plus one
-template<typename Number>
+// natural log of one plus x
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number log1p(const Number x)
 {
   Number one(1.0);
-  return  one + log<Number>(x);
+  return  log<Number>(one + x);
 };
 
 
 // Returns the Scale significand using
 // floating-point base exponent
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number scalbn(const Number x, int n)
 {
   double nd(n);
@@ -122,7 +276,7 @@ FORCE_INLINE Number scalbn(const Number x, int n)
 
 // Returns the Scale significand using
 // floating-point base exponent (long)
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number scalbln(const Number x, long int n)
 {
   double nd(n);
@@ -5,7 +5,7 @@
 
 // Returns the hyperbolic Cosine
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number cosh(const Number theta){
   Number half(0.5), expX(exp<Number>(theta)), expMX(exp<Number>(-theta));
   return half*(expX + expMX);
@@ -14,7 +14,7 @@ FORCE_INLINE Number cosh(const Number theta){
 
 // Returns the hyperbolic Sine
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number sinh(const Number theta){
   Number half(0.5), expX(exp<Number>(theta)), expMX(exp<Number>(-theta));
   return half*(expX - expMX);
@@ -23,7 +23,7 @@ FORCE_INLINE Number sinh(const Number theta){
 
 // Returns the hyperbolic tangent
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number tanh(const Number theta){
   Number half(0.5), expX(exp<Number>(theta)), expMX(exp<Number>(-theta));
   return (expX - expMX)/(expX + expMX);
@@ -32,7 +32,7 @@ FORCE_INLINE Number tanh(const Number theta){
 
 // Returns the area hyperbolic cosine
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number acosh(const Number x){
   Number one(1.00);
   return  log<Number>(x + sqrt<Number>(x*x - one) );
@@ -41,7 +41,7 @@ FORCE_INLINE Number acosh(const Number x){
 
 // Returns the area hyperbolic sine
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number asinh(const Number x){
   Number one(1.00);
   return log<Number>(x + sqrt<Number>(x*x + one) );
@@ -50,7 +50,7 @@ FORCE_INLINE Number asinh(const Number x){
 
 // Returns the area hyperbolic tangent
 // function of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number atanh(const Number x){
   Number half(0.50), one(1.00);
   return half*log<Number>( (one + x)/(one - x) );
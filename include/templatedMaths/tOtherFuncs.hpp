@@ -6,7 +6,7 @@
 // Returns the absolute value of
 // a function, doesn't work for
 // complex numbers
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number abs(const Number z){
   return  sqrt<Number>(z*z);
 };
@@ -15,7 +15,7 @@ FORCE_INLINE Number abs(const Number z){
 // Returns the absolute value of
 // a function, doesn't work for
 // complex numbers
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number fabs(const Number z){
   return  sqrt<Number>(z*z);
 };
@@ -23,7 +23,7 @@ FORCE_INLINE Number fabs(const Number z){
 
 // Returns the multiply add function
 // for single number types
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number fma(const Number x, const Number y, const Number z){
   return x*y + z;
 };
@@ -22,7 +22,7 @@ void GenTCMathFuncMap(std::map<std::string, std::function<REAL(const REAL)> & Si
   SingleInputFuncs["acos"]  = acos<REAL>;  //Arc-cosine function (Radians)
   SingleInputFuncs["asin"]  = asin<REAL>;  //Arc-sine function (Radians)
   SingleInputFuncs["atan"]  = atan<REAL>;  //Arc-tangent function (Radians)
-  SingleInputFuncs["atan2"] = atan2<REAL>; //Arc-tangent 2nd quadrant function (Radians)
+  //atan2(y,x) takes two inputs (see tTrigFuncs.hpp)
 
   //templated HypFuncs
   SingleInputFuncs["cosh"]  = cosh<REAL>;  //Hyperbolic cosine function
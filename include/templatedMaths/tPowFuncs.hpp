@@ -1,11 +1,14 @@
 #pragma once
+#include <cmath>
+#include <numeric>
+#include <type_traits>
 #include "../UtilityObjects/macros.hpp"
 #include "tExpLogFuncs.hpp"
 
 // Returns the pow(x,y) function
 // using log and exponent relations
 // x^y = exp(y.log(x))
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number pow(const Number x, const Number y)
 {
   Number YlogX  = y*log<Number>(x);
@@ -14,47 +17,183 @@ FORCE_INLINE Number pow(const Number x, const Number y)
 };
 
 
+// Returns x^N for a compile time integer N
+// as a binary multiplication chain, even
+// powers square the half power and odd
+// powers take one more multiply by x
+// (x^5 = x.(x^2)^2), negative N gives 1/x^|N|
+template<int N, typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number pow(const Number x)
+{
+  using S = tScalarType<Number>;
+  if constexpr(N < 0){
+    return S(1.0)/pow<-N>(x);
+  }else if constexpr(N == 0){
+    return Number(S(1.0));
+  }else if constexpr(N == 1){
+    return x;
+  }else if constexpr(N % 2 == 0){
+    const Number xHalf = pow<N/2>(x);
+    return xHalf*xHalf;
+  }else{
+    return x*pow<N-1>(x);
+  }
+};
+
+
+// Returns x^n for a run time integer n
+// by binary exponentiation (squaring)
+template<typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number pow(const Number x, const int n)
+{
+  using S = tScalarType<Number>;
+  unsigned m = (n < 0)? 0u - unsigned(n):unsigned(n);
+  Number xPowN(S(1.0)), xPow2K(x);
+
+  while(m != 0){
+    if(m & 1u) xPowN = xPowN*xPow2K;
+    m = m >> 1;
+    if(m != 0) xPow2K = xPow2K*xPow2K;
+  }
+  return (n < 0)? S(1.0)/xPowN:xPowN;
+};
+
+
 // Returns the sqrt of a number
-// by using 5 iterations of 
-// halley's method
-template<typename Number>
+// x = 4^e.m with m in [sqrt(1/2),2.sqrt(2))
+// a quadratic (1% error) first guess of
+// sqrt(m) and Newton iterations
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number sqrt(const Number x)
 {
-  double two=2.0, three=3.0;
-  Number sqrtX(0.6*x), Q(0.0), D(0.0);
+  using S = tScalarType<Number>;
+  constexpr double c[3]={0.45654945395917856, 0.5971697978777514, -0.05844240439066446};
+
+  //Out of range values
+  const double p = primalValue(x);
+  if(p != p)  return x;
+  if(p < 0.0) return Number(S(std::numeric_limits<double>::quiet_NaN()));
+  if((p == 0.0) or (p == std::numeric_limits<double>::infinity())) return x;
 
+  //Reduce to an even exponent
+  const int e = tExponentSqrt2(p) & ~1;
+  Number m = tLdexp(x, -e);
+  Number sqrtM = tHorner<3>(m, c);
+
+  //Quadratic convergence 1e-2 -> 1e-18
+  constexpr unsigned nIter = tIsSingle<Number>? 2:3;
   #pragma unroll
-  for(unsigned I=0; I<3; I++){
-    Q = two*sqrtX*(sqrtX*sqrtX - x);
-    D = three*sqrtX*sqrtX + x;
-    sqrtX = sqrtX - Q/D;
-  }
-  return sqrtX;
+  for(unsigned I=0; I<nIter; I++) sqrtM = S(0.5)*(sqrtM + m/sqrtM);
+  return tLdexp(sqrtM, e/2);
 };
 
 
 // Returns the cbrt of a number
-// by using 6 iterations of 
-// halley's method
-template<typename Number>
+// |x| = 2^(3k+j).m with m in [sqrt(1/2),sqrt(2))
+// and j in {0,1,2}, a quadratic (1e-3 error)
+// first guess of cbrt(m), scaled by 2^(j/3),
+// a Halley and a Newton step on 2^j.m, the
+// sign is restored
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number cbrt(const Number x)
 {
-  double three=3.00, six=6.00;
-  Number cbrtX(0.1*x), Q(0.0), D(0.0);
+  using S = tScalarType<Number>;
+  constexpr double c[3]={0.5574239481027832, 0.546252116043505, -0.10398876445584465};
+  constexpr double cbrt2j[3]={1.0, 1.25992104989487316477, 1.58740105196819947475};
 
-  #pragma unroll
-  for(unsigned I=0; I<6; I++){
-    Q = three*cbrtX*(cbrtX*cbrtX*cbrtX - x);
-    D = six*cbrtX*cbrtX*cbrtX + three*x;
-    cbrtX = cbrtX - Q/D;
+  //Out of range values (odd function)
+  const double p = primalValue(x);
+  if((p != p) or (p == 0.0) or (p == std::numeric_limits<double>::infinity())
+              or (p == -std::numeric_limits<double>::infinity())) return x;
+  const double sgn = (p < 0.0)? -1.0:1.0;
+  Number ax = S(sgn)*x;
+
+  //Reduce to an exponent multiple of 3
+  const int e = tExponentSqrt2(sgn*p);
+  const int k = (e >= 0)? e/3: -((2 - e)/3);
+  const int j = e - 3*k;
+  Number m = tLdexp(ax, -3*k);
+  Number cbrtM = tHorner<3>(tLdexp(m, -j), c)*S(cbrt2j[j]);
+
+  //A Halley step 1e-3 -> 1e-9 then a Newton
+  //step 1e-9 -> 1e-18 as a small correction
+  //(rounded once, about 1 ULP)
+  Number cube = cbrtM*cbrtM*cbrtM;
+  cbrtM = cbrtM*(cube + S(2.0)*m)/(S(2.0)*cube + m);
+  Number sq = cbrtM*cbrtM;
+  cbrtM = cbrtM - (sq*cbrtM - m)/(S(3.0)*sq);
+  return S(sgn)*tLdexp(cbrtM, k);
+};
+
+
+// The Q-th root of a positive normal or
+// subnormal scalar (odd Q > 3) |x| = 2^(Qk).m
+// with m in [sqrt(1/2),2^Q.sqrt(2)), the
+// guess exp(log(m)/Q) and a Newton step
+template<int Q, typename S>
+FORCE_INLINE S tRootScalar(const S x)
+{
+  const int e = tExponentSqrt2(double(x));
+  const int k = (e >= 0)? e/Q: -((Q - 1 - e)/Q);
+  const S m = tLdexp(x, -Q*k);
+  S y = exp<S>(log<S>(m)*S(1.0/double(Q)));
+  const S yQ1 = pow<Q-1>(y);
+  y = y - (yQ1*y - m)/(S(Q)*yQ1);
+  return tLdexp(y, k);
+};
+
+
+// Returns the Q-th root of x for a compile
+// time integer Q, sqrt and cbrt (std::cbrt
+// for the scalars) where possible, the odd
+// roots keep the sign of x and 0 -> 0
+template<int Q, typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number tRoot(const Number x)
+{
+  using S = tScalarType<Number>;
+  static_assert(Q > 0, "tRoot: the root must be positive");
+  if constexpr(Q == 1){
+    return x;
+  }else if constexpr(Q == 2){
+    return sqrt(x);
+  }else if constexpr(Q == 3){
+    if constexpr(std::is_floating_point<Number>::value){
+      return std::cbrt(x);
+    }else{
+      return cbrt(x);
+    }
+  }else if constexpr(Q % 2 == 0){
+    return tRoot<Q/2>(sqrt(x));
+  }else{
+    //Out of range values
+    const double p = primalValue(x);
+    if((p != p) or (p == 0.0) or (p == std::numeric_limits<double>::infinity())
+                or (p == -std::numeric_limits<double>::infinity())) return x;
+    const S sgn = (p < 0.0)? S(-1.0):S(1.0);
+    if constexpr(std::is_floating_point<Number>::value){
+      return sgn*tRootScalar<Q,S>(sgn*x);
+    }else{
+      return sgn*exp(log(sgn*x)*S(1.0/double(Q)));
+    }
   }
-  return cbrtX;
+};
+
+
+// Returns x^(P/Q) for compile time integers
+// the exponent is reduced, then the root
+// of x is raised to P by the multiplication
+// chain (x^(3/2) = sqrt(x)^3)
+template<int P, int Q, typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number pow(const Number x)
+{
+  constexpr int D = std::gcd(P, Q);
+  return pow<P/D>(tRoot<Q/D>(x));
 };
 
 
 // Gets the hypotenuse of
 // a right-angled triangle
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number hypot(const Number x, const Number y)
 {
   return sqrt<Number>(x*x + y*y);
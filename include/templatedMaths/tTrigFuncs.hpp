@@ -1,121 +1,245 @@
 #pragma once
+#include <cmath>
+#include <limits>
 #include "../UtilityObjects/macros.hpp"
 #include "tPowFuncs.hpp"
 
-// Returns the Sine function
-// of a number using a 15th order
-// polynomial with an appropriate
-// integer multiple of PI offset
+// The sin/cos kernel constants, PI/2 is
+// split in 3 parts so k.part is exact,
+// shared by the scalar and batched kernels
+template<bool single>
+struct tTrigConsts{
+  static constexpr double twoOverPI = 6.36619772367581382433e-01;
+  static constexpr double pio2_1 = single? 1.57080078125           : 1.57079632673412561417e+00;
+  static constexpr double pio2_2 = single? -4.453584551811218e-06  : 6.07710050630396597660e-11;
+  static constexpr double pio2_3 = single? -8.705515752716053e-10  : 2.02226624879595063154e-21;
+  static constexpr double maxCodyWaite = single? 6e3: 1e6;
+  static constexpr unsigned nS = single? 4:6;
+  static constexpr double S[6]={-1.66666666666666324348e-01 , 8.33333333332248946124e-03
+                               ,-1.98412698298579493134e-04 , 2.75573137070700676789e-06
+                               ,-2.50507602534068634195e-08 , 1.58969099521155010221e-10};
+  static constexpr unsigned nC = single? 5:7;
+  static constexpr double C[7]={-0.5
+                               , 4.16666666666666019037e-02 , -1.38888888888741095749e-03
+                               , 2.48015872894767294178e-05 , -2.75573143513906633035e-07
+                               , 2.08757232129817482790e-09 , -1.13596475577881948265e-11};
+};
+
+/*****************************************\
+!
+!  The reduction of a large primal p
+!  (|p| > maxCodyWaite), the quadrant and
+!  rp from the (exactly reduced) <cmath>
+!  sin/cos of p:
+!   sin(p) = sin(q.PI/2 + rp)
+!  with rp = atan2 of the pair that has
+!  cos(rp) >= |sin(rp)|, the derivatives
+!  of theta are kept by
+!   r = (theta - p) + rp
+!
+\*****************************************/
 template<typename Number>
-FORCE_INLINE Number sin1(const Number theta, const Number a){
-  const double PI=3.14159;
-  constexpr double coeffs[8]={1.0                  //Term 1   1
-                            ,-1.0/6.0              //Term 3   2
-                            , 1.0/120              //Term 5   3
-                            ,-1.0/5040.0           //Term 7   4
-                            , 1.0/362880.0         //Term 9   5
-                            ,-1.0/39916800.0       //Term 11  6
-                            , 1.0/6227020800.0     //Term 13  7
-                            ,-1.0/130764378000.0}; //Term 15  8
-  Number x = (theta - a);
-  Number x2 = x*x;
-  Number sinX(0.0);
-  #pragma unroll
-  for(unsigned I=0; I<8; I++){
-    sinX = sinX + coeffs[I]*x;
-    x = x*x2;
+unsigned tReducePio2Large(const Number & theta, const double p, Number & r)
+{
+  using S = tScalarType<Number>;
+  const double s = std::sin(p), c = std::cos(p);
+  unsigned q;
+  double sr, cr;
+  if(std::fabs(s) <= std::fabs(c)){
+    q  = (c > 0.0)? 0:2;
+    sr = (c > 0.0)? s:-s;
+    cr = std::fabs(c);
+  }else{
+    q  = (s > 0.0)? 1:3;
+    sr = (s > 0.0)? -c:c;
+    cr = std::fabs(s);
   }
-  return sinX;
+  r = (theta - S(p)) + S(std::atan2(sr, cr));
+  return q;
+};
+
+/*****************************************\
+!
+!  Constant time (Cody-Waite) reduction
+!  theta = k.PI/2 + r, |r| <= PI/4,
+!  accurate for |theta| up to ~1e6
+!  (double) and ~6e3 (float), larger
+!  arguments use tReducePio2Large
+!
+\*****************************************/
+template<typename Number>
+FORCE_INLINE unsigned tReducePio2(const Number & theta, Number & r)
+{
+  using S = tScalarType<Number>;
+  using K = tTrigConsts<tIsSingle<Number>>;
+  const double p = primalValue(theta);
+  if(std::fabs(p) > K::maxCodyWaite) return tReducePio2Large<Number>(theta, p, r);
+  const double k = tRoundNearest(p*K::twoOverPI);
+  r = theta - S(k*K::pio2_1);
+  r = r - S(k*K::pio2_2);
+  r = r - S(k*K::pio2_3);
+  return unsigned(INT64(k) & 3);
 };
 
+// sin/cos/tan of NaN and +-inf are NaN
+template<typename Number>
+FORCE_INLINE bool tTrigNonFinite(const Number & theta)
+{
+  const double p = primalValue(theta);
+  return (p != p) or (p == std::numeric_limits<double>::infinity())
+                  or (p == -std::numeric_limits<double>::infinity());
+};
+
+// The sine kernel on |r| <= PI/4
+// minimax polynomial in r^2
+template<typename Number>
+FORCE_INLINE Number tSinKernel(const Number & r)
+{
+  using K = tTrigConsts<tIsSingle<Number>>;
+  Number z = r*r;
+  return r + (r*z)*tHorner<K::nS>(z, K::S);
+};
+
+// The cosine kernel on |r| <= PI/4
+// minimax polynomial in r^2
+template<typename Number>
+FORCE_INLINE Number tCosKernel(const Number & r)
+{
+  using S = tScalarType<Number>;
+  using K = tTrigConsts<tIsSingle<Number>>;
+  Number z = r*r;
+  return z*tHorner<K::nC>(z, K::C) + S(1.0);
+};
+
+
 // Returns the sin function
 // of a variable
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number sin(const Number theta){
-  const double PI=3.14159265358979323846264338328;
-  double a, dec;
-  Number A(0.0);
-  if(theta >=   PI)  dec =  2.0*PI;
-  if(theta <= (-PI)) dec = -2.0*PI;
-  for(int I=0; ;I++){
-    a=double(I)*dec;
-    if(( (theta-a) <= PI )and( (-PI)  <= (theta-a) )) break;
+  using S = tScalarType<Number>;
+  if(tTrigNonFinite(theta)) return Number(S(std::numeric_limits<double>::quiet_NaN()));
+  Number r;
+  switch(tReducePio2<Number>(theta, r)){
+    case 0:  return tSinKernel<Number>(r);
+    case 1:  return tCosKernel<Number>(r);
+    case 2:  return -1.0*tSinKernel<Number>(r);
+    default: return -1.0*tCosKernel<Number>(r);
   }
-  A=Number(a);
-  return sin1<Number>(theta,A);
 };
 
 // Returns the Cosine function
 // of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number cos(const Number theta){
-  Number s = sin<Number>(theta);
-  return sqrt<Number>(1.0 - s*s);
+  using S = tScalarType<Number>;
+  if(tTrigNonFinite(theta)) return Number(S(std::numeric_limits<double>::quiet_NaN()));
+  Number r;
+  switch(tReducePio2<Number>(theta, r)){
+    case 0:  return tCosKernel<Number>(r);
+    case 1:  return -1.0*tSinKernel<Number>(r);
+    case 2:  return -1.0*tCosKernel<Number>(r);
+    default: return tSinKernel<Number>(r);
+  }
 };
 
 // Returns the tangent
 // of a number
-template<typename Number>
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number tan(const Number theta){
-  Number s = sin<Number>(theta);
-  Number c = sqrt<Number>(1.0 - s*s);
+  using S = tScalarType<Number>;
+  if(tTrigNonFinite(theta)) return Number(S(std::numeric_limits<double>::quiet_NaN()));
+  Number r;
+  const unsigned q = tReducePio2<Number>(theta, r);
+  Number s = tSinKernel<Number>(r), c = tCosKernel<Number>(r);
+  if(q & 1) return -1.0*c/s;
   return s/c;
 };
 
-// The arc-cosine
-// function
-template<typename Number>
+// The arc-tangent function, reduced
+// to |t| <= 7/16 with the identities
+// atan(x) = atan(c) + atan((x-c)/(1+c.x))
+// for c = 0.5, 1, 1.5 and inf, and a
+// minimax polynomial kernel
+template<typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number atan(const Number x){
+  using S = tScalarType<Number>;
+  constexpr double atanHI[4]={ 4.63647609000806093515e-01, 7.85398163397448278999e-01
+                             , 9.82793723247329054082e-01, 1.57079632679489655800e+00};
+  constexpr double atanLO[4]={ 2.26987774529616870924e-17, 3.06161699786838301793e-17
+                             , 1.39033110312309984516e-17, 6.12323399573676603587e-17};
+  constexpr double aTeven[6]={ 3.33333333333329318027e-01, 1.42857142725034663711e-01
+                             , 9.09088713343650656196e-02, 6.66107313738753120669e-02
+                             , 4.97687799461593236017e-02, 1.62858201153657823623e-02};
+  constexpr double aTodd[5] ={-1.99999999998764832476e-01,-1.11111104054623557880e-01
+                             ,-7.69187620504482999495e-02,-5.83357013379057348645e-02
+                             ,-3.65315727442169155270e-02};
+
+  //Odd function, work with |x|
+  const double p = primalValue(x);
+  if(p != p) return x;
+  const double sgn = (p < 0.0)? -1.0:1.0;
+  const double a = sgn*p;
+  Number ax = S(sgn)*x, t;
+  int id;
+  if(a < 0.4375){        id=-1; t = ax;}
+  else if(a < 0.6875){   id=0;  t = (S(2.0)*ax - S(1.0))/(ax + S(2.0));}
+  else if(a < 1.1875){   id=1;  t = (ax - S(1.0))/(ax + S(1.0));}
+  else if(a < 2.4375){   id=2;  t = (ax - S(1.5))/(S(1.5)*ax + S(1.0));}
+  else if(a < 1.0e300){  id=3;  t = S(-1.0)/ax;}
+  else return Number(S(sgn*atanHI[3]));
+
+  //Kernel, split in even and odd powers of t^2
+  Number z = t*t;
+  Number w = z*z;
+  Number s1 = z*tHorner<6>(w, aTeven);
+  Number s2 = w*tHorner<5>(w, aTodd);
+  if(id < 0) return S(sgn)*(t - t*(s1 + s2));
+  Number atanT = S(atanHI[id]) - ((t*(s1 + s2) - S(atanLO[id])) - t);
+  return S(sgn)*atanT;
+};
+
+// The arc-cosine function
+// acos(x) = 2.atan(sqrt((1-x)/(1+x)))
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number acos(const Number x){
-  Number one(1.00), half(0.5), Q(0.00), D(0.00);
-  Number acosT(0.00), cs(0.00), sn(0.00);
-
-  //Use iterative formula x - cos(theta) = 0
-  //and solve with 10 iterations of
-  //Halley's Method
-  #pragma unroll
-  for(unsigned I=0; I<10; I++){
-    sn =  sin<Number>(acosT);
-    cs =  cos<Number>(acosT);
-    Q  = (x - cs)*sn;
-    D  = (one - half*cs*cs - half*x*cs);
-    acosT = acosT - Q/D;
-  }
-  return acosT;
+  using S = tScalarType<Number>;
+  Number q = (S(1.0) - x)/(S(1.0) + x);
+  return S(2.0)*atan<Number>(sqrt<Number>(q));
 };
 
-// The arc-sine
-// function
-template<typename Number>
+// The arc-sine function
+// asin(x) = atan(x/sqrt((1-x)(1+x)))
+template<typename Number, typename = tNumberArg<Number>>
 FORCE_INLINE Number asin(const Number x){
-  Number one(1.00), half(0.5), Q(0.00), D(0.00);
-  Number asinT(0.00), cs(0.00), sn(0.00);
-
-  //Use iterative formula x - cos(theta) = 0
-  //and solve with 10 iterations of
-  //Halley's Method
-  #pragma unroll
-  for(unsigned I=0; I<10; I++){
-    sn =  sin<Number>(asinT);
-    cs =  cos<Number>(asinT);
-    Q  = (sn - x)*cs;
-    D  = (one - half*sn*sn - half*x*cs);
-    asinT = asinT - Q/D;
-  }
-  return asinT;
+  using S = tScalarType<Number>;
+  Number c = sqrt<Number>((S(1.0) - x)*(S(1.0) + x));
+  return atan<Number>(x/c);
 };
 
-// The arc-tangent
-// function
-template<typename Number>
-FORCE_INLINE Number atan(const Number x){
-  Number one(1.00), half(0.5), Q(0.00), D(0.00);
-  Number atanT(0.00), cs(0.00), sn(0.00);
-  return atanT;
-};
+// The arc-tangent of y/x in the quadrant
+// of (x,y), in [-PI,PI]:
+//  |y| <= |x| : atan(y/x) (+-PI for x < 0)
+//  |y| >  |x| : +-PI/2 - atan(x/y)
+// (the derivatives follow the same
+// branch), the signed zeros and the
+// infinities as std::atan2
+template<typename Number, typename = tNumberArg<Number>>
+FORCE_INLINE Number atan2(const Number y, const Number x){
+  using S = tScalarType<Number>;
+  constexpr double PI = 3.14159265358979323846, inf = std::numeric_limits<double>::infinity();
+  const double py = primalValue(y), px = primalValue(x);
+  if(py != py) return y;
+  if(px != px) return x;
+  const double sy = std::signbit(py)? -1.0:1.0;
 
-// Not really implemented yet
-//
-template<typename Number>
-FORCE_INLINE Number atan2(const Number theta){
-  return Number(0.0);
+  //Zeros and infinities (constant)
+  if((py == 0.0) and (px == 0.0)) return Number(S(std::signbit(px)? sy*PI: sy*0.0));
+  if((std::fabs(py) == inf) and (std::fabs(px) == inf)) return Number(S(sy*((px > 0.0)? 0.25*PI: 0.75*PI)));
+
+  if(std::fabs(py) <= std::fabs(px)){
+    Number a = atan(y/x);
+    if(std::signbit(px)) return a + S(sy*PI);
+    return a;
+  }
+  return S(sy*0.5*PI) - atan(x/y);
 };
@@ -5,6 +5,7 @@
 #include <cmath>
 #include "mfem.hpp"
 #include "include/nlOperator/tADNonLinearForm.hpp"
+#include "include/nlSolver/tNewtonSolver.hpp"
 #include "include/UtilityObjects/Visualisation.hpp"
 
 // Mathematical objects
@@ -15,11 +16,14 @@
 // Mathematical Functions
 #include "include/templatedMaths/tCmath.hpp"
 
+// Energy functionals
+#include "include/energyFunctional/linearElasticityTCoeff.hpp"
+
 
 int main(){
   // 1. Initialize MPI and HYPRE.
   //    and Parse command-line options
-  Mpi::Init();
+  Mpi::Init(MPI_THREAD_FUNNELED);
   const int myid = Mpi::WorldRank();
   int ref_levels=-1, order=2;
   const char *mesh_file = "data/star.mesh";
@@ -37,12 +41,12 @@ int main(){
 
   // 3. Define a finite element space on the mesh. Here we use H1 continuous
   //    high-order Lagrange finite elements of the given order.
+  MFEM_VERIFY(dim == 2, "The test case is 2D");
   H1_FECollection fec(order, dim);
-  ParFiniteElementSpace fespace(&pmesh, &fec);
+  ParFiniteElementSpace fespace(&pmesh, &fec, dim);
   std::vector<mfem::ParGridFunction*> gFuncs;
   std::vector<std::string>            FieldNames;
-  gFuncs.push_back(new mfem::ParGridFunction(&fespace)); FieldNames.push_back("field_1");
-  gFuncs.push_back(new mfem::ParGridFunction(&fespace)); FieldNames.push_back("field_2");
+  gFuncs.push_back(new mfem::ParGridFunction(&fespace)); FieldNames.push_back("displacement");
 
   int NEQs=0;
   for(int I=0; I<gFuncs.size(); I++) NEQs += gFuncs[I]->ParFESpace()->GetTrueVSize();
@@ -52,13 +56,144 @@ int main(){
   //form (make sure it compiles 
   //and runs)
   tADNLForm<mfem::real_t> nlProb(gFuncs, device, mt, use_dev);
-  nlProb.buildJacobian(x);
+
+  // 4. Sample the displacement gradient du/dxi
+  //    and add a linear elastic energy
+  const IntegrationRule & ir = IntRules.Get(pmesh.GetElementBaseGeometry(0), 2*order);
+  const unsigned integID = nlProb.AddIntegRule(ir);
+  mfem::DenseMatrix gradInterp;
+  tInterpolator::ShapeGrads(*fespace.GetFE(0), dim, ir, gradInterp);
+  nlProb.AddTVar(Var<int>{0, 2, {dim, dim}}, gradInterp);
+  nlProb.AddEnergy(TLElasticityCoeffIntegrator<mfem::real_t,2>(Array<int>({0}), integID, 1.0, 10.0));
+  nlProb.PrepareOperator();
+
+  // 5. A uniform stretch, evaluate the residual
+  VectorFunctionCoefficient stretch(dim, [](const Vector & X, Vector & U){U = X; U *= 0.01;});
+  gFuncs[0]->ProjectCoefficient(stretch);
+  gFuncs[0]->GetTrueDofs(x);
   nlProb.Mult(x,y);
+  if(myid == 0) std::cout << "|R(x)| = " << y.Norml2() << std::endl;
+
+  //Threaded host loops (coloured
+  //scatter), the same residual
+  mfem::Vector yThreads(NEQs,mt);
+  tHostThreads::SetNumThreads(4);
+  nlProb.Mult(x,yThreads);
+  yThreads -= y;
+  if(myid == 0) std::cout << "|R(x) - R_threads(x)| = " << yThreads.Norml2() << std::endl;
+
+  //Reverse-mode (taped) residual, the
+  //same gradients as the dual numbers
+  mfem::Vector yTape(NEQs,mt);
+  nlProb.SetReverseMode(true);
+  nlProb.Mult(x,yTape);
+  nlProb.SetReverseMode(false);
+  yTape -= y;
+  if(myid == 0) std::cout << "|R(x) - R_tape(x)| = " << yTape.Norml2() << std::endl;
+
+  //The energy and a finite difference of
+  //the energy along x (should be R(x).x)
+  const real_t eps=1e-6, e0 = nlProb.GetEnergy(x);
+  mfem::Vector xEps(x);
+  xEps *= 1.0 + eps;
+  const real_t dedx = (nlProb.GetEnergy(xEps) - e0)/eps;
+  const real_t Rx = InnerProduct(MPI_COMM_WORLD, y, x);
+  if(myid == 0) std::cout << "e(x) = " << e0 << ", de/dx.x = " << dedx << ", R(x).x = " << Rx << std::endl;
+
+  //Fused residual and Jacobian (one pass)
+  mfem::Vector yFused(NEQs,mt);
+  nlProb.MultAndGradient(x,yFused);
+  yFused -= y;
+  if(myid == 0) std::cout << "|R(x) - R_fused(x)| = " << yFused.Norml2() << std::endl;
+
+  //Assembled and matrix-free Jacobian
+  //actions (should agree)
+  mfem::Vector Jx(NEQs,mt);
+  nlProb.GetGradient(x).Mult(x,Jx);
+  for(AssemblyLevel level : {AssemblyLevel::ELEMENT, AssemblyLevel::PARTIAL, AssemblyLevel::NONE}){
+    nlProb.SetAssemblyLevel(level);
+    nlProb.GetGradient(x).Mult(x,y);
+    y -= Jx;
+    if(myid == 0) std::cout << "|J.x - J_level.x| = " << y.Norml2() << std::endl;
+  }
 
-  // 5. Output the vector data
+  //Incremental Jacobian, only the elements
+  //of the perturbed DOF are relinearised
+  nlProb.SetAssemblyLevel(AssemblyLevel::FULL);
+  nlProb.SetIncrementalJacobian(1e-12);
+  nlProb.GetGradient(x);
+  xEps = x;
+  if(NEQs > 0) xEps(0) += 1e-3;
+  nlProb.GetGradient(xEps).Mult(x,y);
+  y -= Jx;
+  if(myid == 0) std::cout << "relinearised " << nlProb.GetNumRelinearised() << " elements, |J.x - J_incr.x| = " << y.Norml2() << std::endl;
+  nlProb.SetIncrementalJacobian(-1.0);
+
+  // 6. Solve with the stretch on the boundary
+  //    and zero inside (the solution is the
+  //    uniform stretch)
+  mfem::Array<int> ess_bdr(pmesh.bdr_attributes.Max()), ess_tdofs;
+  ess_bdr = 1;
+  fespace.GetEssentialTrueDofs(ess_bdr, ess_tdofs);
+  nlProb.SetEssentialTrueDofs(ess_tdofs);
+  nlProb.SetAssemblyLevel(AssemblyLevel::FULL);
+  mfem::Vector xSol(NEQs,mt);
+  xSol = 0.0;
+  for(int I=0; I<ess_tdofs.Size(); I++) xSol(ess_tdofs[I]) = x(ess_tdofs[I]);
+
+  CGSolver cg(MPI_COMM_WORLD);
+  HypreBoomerAMG amg;
+  amg.SetPrintLevel(0);
+  cg.SetMaxIter(500);
+  tNewtonSolver<tADNLForm<mfem::real_t>> newton(nlProb, cg, amg, MPI_COMM_WORLD);
+  newton.SetRelTol(1e-10);
+  newton.Mult(xSol);
+  mfem::Vector xErr(xSol);
+  xErr -= x;
+  const real_t errNorm = std::sqrt(InnerProduct(MPI_COMM_WORLD, xErr, xErr));
+  if(myid == 0) std::cout << "Newton its = " << newton.GetNumIterations() << ", converged = " << newton.GetConverged()
+                          << ", |x - x_exact| = " << errNorm << std::endl;
+  gFuncs[0]->SetFromTrueDofs(xSol);
+
+  // 7. Output the vector data
   //    into paraview 
   ParaViewVisualise("testNLProblem",gFuncs,FieldNames,order,&pmesh,0.00);
 
+  // 8. Cost-weighted repartitioning, a
+  //    conforming ParMesh is repartitioned
+  //    into a new ParMesh (to rebuild the
+  //    spaces and form on), a nonconforming
+  //    ParMesh can migrate its elements (and
+  //    the TrueVars)
+  nlProb.SetElementTiming(true);
+  nlProb.Mult(x,y);
+  mfem::ParMesh *wmesh = nlProb.RebalancedMesh(1.0);
+  if(myid == 0) std::cout << "conforming repartition " << (wmesh != NULL) << ", Rebalance " << nlProb.Rebalance(1.0) << std::endl;
+  delete wmesh;
+
+  mesh.EnsureNCMesh();
+  ParMesh ncmesh(MPI_COMM_WORLD, mesh);
+  ParFiniteElementSpace ncspace(&ncmesh, &fec, dim);
+  std::vector<mfem::ParGridFunction*> ncFuncs{new mfem::ParGridFunction(&ncspace)};
+  ncFuncs[0]->ProjectCoefficient(stretch);
+  tADNLForm<mfem::real_t> ncProb(ncFuncs, device, mt, use_dev);
+  const unsigned ncIntegID = ncProb.AddIntegRule(ir);
+  ncProb.AddTVar(Var<int>{0, 2, {dim, dim}}, gradInterp);
+  ncProb.AddEnergy(TLElasticityCoeffIntegrator<mfem::real_t,2>(Array<int>({0}), ncIntegID, 1.0, 10.0));
+  ncProb.PrepareOperator();
+
+  mfem::Vector xNC(ncProb.Height(),mt), yNC(ncProb.Height(),mt);
+  ncFuncs[0]->GetTrueDofs(xNC);
+  ncProb.SetElementTiming(true);
+  for(int I=0; I<3; I++) ncProb.Mult(xNC,yNC);
+  const real_t eBefore = ncProb.GetEnergy(xNC);
+  const bool moved = ncProb.Rebalance(1.0);
+  xNC.SetSize(ncProb.Height());
+  ncFuncs[0]->GetTrueDofs(xNC);
+  const real_t eAfter = ncProb.GetEnergy(xNC);
+  if(myid == 0) std::cout << "rebalanced " << moved << ", e(x) before = " << eBefore << ", after = " << eAfter << std::endl;
+  delete ncFuncs[0];
+
   // Delete the objects
   // an clean-up
   for(int I=0; I<gFuncs.size(); I++) delete gFuncs[I];
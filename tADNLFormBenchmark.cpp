@@ -0,0 +1,174 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include "mfem.hpp"
+#include "include/nlOperator/tADNonLinearForm.hpp"
+
+// Energy functionals
+#include "include/energyFunctional/neoHookeanTCoeff.hpp"
+
+/*****************************************\
+!
+!  Residual benchmark of tADNLForm against
+!  an mfem::ParNonlinearForm with the hand
+!  written HyperelasticNLFIntegrator, both
+!  evaluate the neo-Hookean residual of the
+!  deformed positions x (vector H1):
+!   W = mu/2.(J^(-2/dim).F:F - dim)
+!     + K/2.(J - 1)^2,  F = dx/dX
+!  the Mult times are averaged over nReps
+!  and the residuals are compared, the AD
+!  residual is also evaluated in reverse
+!  mode (tapeNumber) and cross-checked
+!  against the forward mode (dualVecNumber)
+!  and the mixed precision form (float
+!  evaluation, double accumulation) is
+!  compared with the double form (the
+!  residuals and the Jacobian actions)
+!
+\*****************************************/
+//Deformed positions, a
+//stretch and a twist
+void deform(const Vector & X, Vector & x)
+{
+  x = X;
+  x(0) += 0.05*X(0) + 0.02*std::sin(X(1));
+  x(1) += 0.03*X(1) - 0.02*std::sin(X(0));
+};
+
+template<unsigned dim>
+void benchmark(const char *mesh_file, const int ref_levels, const int order, const int nReps)
+{
+  const int myid = Mpi::WorldRank();
+  const real_t mu=1.0, K=10.0;
+  mfem::Device device("cpu");
+  mfem::MemoryType mt = device.GetMemoryType();
+  const bool use_dev=false;
+
+  // 1. Read and refine the mesh
+  Mesh mesh(mesh_file);
+  MFEM_VERIFY(mesh.Dimension() == int(dim), "The mesh dimension does not match");
+  for (int l = 0; l < ref_levels; l++) mesh.UniformRefinement();
+  ParMesh pmesh(MPI_COMM_WORLD, mesh);
+
+  // 2. Positions in vector H1 (ordered by
+  //    nodes), the deformed configuration
+  H1_FECollection fec(order, dim);
+  ParFiniteElementSpace fespace(&pmesh, &fec, dim);
+  std::vector<mfem::ParGridFunction*> gFuncs;
+  gFuncs.push_back(new mfem::ParGridFunction(&fespace));
+  VectorFunctionCoefficient deformed(dim, deform);
+  gFuncs[0]->ProjectCoefficient(deformed);
+
+  const int NEQs = fespace.GetTrueVSize();
+  mfem::Vector x(NEQs,mt), yMFEM(NEQs,mt), yAD(NEQs,mt), yTape(NEQs,mt);
+  gFuncs[0]->GetTrueDofs(x);
+  const IntegrationRule & ir = IntRules.Get(pmesh.GetElementBaseGeometry(0), 2*order + 3);
+
+  // 3. The MFEM form, hand written integrator
+  NeoHookeanModel model(mu, K);
+  ParNonlinearForm nlMFEM(&fespace);
+  HyperelasticNLFIntegrator *integ = new HyperelasticNLFIntegrator(&model);
+  integ->SetIntRule(&ir);
+  nlMFEM.AddDomainIntegrator(integ);
+
+  // 4. The AD form, sampled position
+  //    gradients dx/dxi and the energy
+  tADNLForm<real_t> nlAD(gFuncs, device, mt, use_dev);
+  const unsigned integID = nlAD.AddIntegRule(ir);
+  mfem::DenseMatrix gradInterp;
+  tInterpolator::ShapeGrads(*fespace.GetFE(0), dim, ir, gradInterp);
+  nlAD.AddTVar(Var<int>{0, 2, {int(dim), int(dim)}}, gradInterp);
+  nlAD.AddEnergy(TNeoHookeanCoeffIntegrator<real_t,dim>(mfem::Array<int>({0}), integID, mu, K));
+  nlAD.PrepareOperator();
+
+  // 5. Time the residuals
+  StopWatch tMFEM, tAD, tTape;
+  nlMFEM.Mult(x,yMFEM);
+  nlAD.Mult(x,yAD);
+  tMFEM.Start();
+  for(int I=0; I<nReps; I++) nlMFEM.Mult(x,yMFEM);
+  tMFEM.Stop();
+  tAD.Start();
+  for(int I=0; I<nReps; I++) nlAD.Mult(x,yAD);
+  tAD.Stop();
+
+  //Reverse mode (taped) residual
+  nlAD.SetReverseMode(true);
+  nlAD.Mult(x,yTape);
+  tTape.Start();
+  for(int I=0; I<nReps; I++) nlAD.Mult(x,yTape);
+  tTape.Stop();
+  nlAD.SetReverseMode(false);
+
+  // 6. Compare the residuals
+  mfem::Vector diff(yAD);
+  diff -= yMFEM;
+  const real_t errRel = std::sqrt(InnerProduct(MPI_COMM_WORLD, diff, diff)
+                                / InnerProduct(MPI_COMM_WORLD, yMFEM, yMFEM));
+  diff = yTape;
+  diff -= yAD;
+  const real_t errTape = std::sqrt(InnerProduct(MPI_COMM_WORLD, diff, diff)
+                                 / InnerProduct(MPI_COMM_WORLD, yAD, yAD));
+  const HYPRE_BigInt nElms = pmesh.GetGlobalNE();
+  if(myid == 0){
+    std::cout << mesh_file << " (order " << order << ", " << nElms << " elements)" << std::endl;
+    std::cout << "  ParNonlinearForm Mult : " << 1e3*tMFEM.RealTime()/nReps << " ms" << std::endl;
+    std::cout << "  tADNLForm Mult        : " << 1e3*tAD.RealTime()/nReps   << " ms" << std::endl;
+    std::cout << "  relative difference   : " << errRel << std::endl;
+    std::cout << "  tADNLForm Mult (tape) : " << 1e3*tTape.RealTime()/nReps << " ms" << std::endl;
+    std::cout << "  |R_tape - R_dual|/|R_dual| : " << errTape << std::endl;
+  }
+
+  // 7. Mixed precision form, the same energy
+  //    evaluated in float (the sums in double)
+  tADNLFormMixed nlMixed(gFuncs, device, mt, use_dev);
+  const unsigned integIDMixed = nlMixed.AddIntegRule(ir);
+  nlMixed.AddTVar(Var<int>{0, 2, {int(dim), int(dim)}}, gradInterp);
+  nlMixed.AddEnergy(TNeoHookeanCoeffIntegrator<REAL32,dim>(mfem::Array<int>({0}), integIDMixed, mu, K));
+  nlMixed.PrepareOperator();
+
+  mfem::Vector yMixed(NEQs,mt), v(NEQs,mt), Jv(NEQs,mt), JvMixed(NEQs,mt);
+  StopWatch tMixed;
+  nlMixed.Mult(x,yMixed);
+  tMixed.Start();
+  for(int I=0; I<nReps; I++) nlMixed.Mult(x,yMixed);
+  tMixed.Stop();
+  diff = yMixed;
+  diff -= yAD;
+  const real_t errMixedR = std::sqrt(InnerProduct(MPI_COMM_WORLD, diff, diff)
+                                   / InnerProduct(MPI_COMM_WORLD, yAD, yAD));
+
+  //The Jacobian actions on a smooth v
+  gFuncs[0]->GetTrueDofs(v);
+  nlAD.GetGradient(x).Mult(v,Jv);
+  nlMixed.GetGradient(x).Mult(v,JvMixed);
+  diff = JvMixed;
+  diff -= Jv;
+  const real_t errMixedJ = std::sqrt(InnerProduct(MPI_COMM_WORLD, diff, diff)
+                                   / InnerProduct(MPI_COMM_WORLD, Jv, Jv));
+  if(myid == 0){
+    std::cout << "  tADNLFormMixed Mult   : " << 1e3*tMixed.RealTime()/nReps << " ms" << std::endl;
+    std::cout << "  |R_mixed - R|/|R|     : " << errMixedR << std::endl;
+    std::cout << "  |J_mixed.v - J.v|/|J.v| : " << errMixedJ << std::endl;
+  }
+
+  // 8. Autotune the Jacobian assembly level
+  //    (logs the timings of every level)
+  nlAD.SetAutoTune(20);
+  nlAD.PrepareOperator();
+
+  for(unsigned I=0; I<gFuncs.size(); I++) delete gFuncs[I];
+  gFuncs.clear();
+};
+
+int main(){
+  Mpi::Init();
+  Hypre::Init();
+  const int nReps=10;
+  for(int order : {1, 2}){
+    benchmark<2>("data/star.mesh", 4, order, nReps);
+    benchmark<3>("data/beam-tet.mesh", 2, order, nReps);
+  }
+  return 0;
+};
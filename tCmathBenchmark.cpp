@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+// Mathematical objects
+#include "include/templatedMathObjs/dualNumber.hpp"
+
+// Mathematical Functions
+#include "include/templatedMaths/tCmath.hpp"
+
+/*****************************************\
+!
+!  Accuracy vs throughput of the templated
+!  maths kernels against <cmath>, reports
+!  ns/call and the max ULP error for
+!  double, float and dual numbers
+!  (for the dual numbers both the generic
+!  kernel and the analytic overload are
+!  timed, the ULP error is of the generic
+!  kernel value and gradient)
+!
+\*****************************************/
+using dual_t = dualNumber<double,double>;
+
+//Units in the last place of the error
+template<typename T>
+double ulpError(const T a, const T ref)
+{
+  if(a == ref) return 0.0;
+  if(std::isnan(a) or std::isnan(ref)) return std::numeric_limits<double>::infinity();
+  const T absRef = std::fabs(ref);
+  const T ulp = std::nextafter(absRef, std::numeric_limits<T>::infinity()) - absRef;
+  return std::fabs(double(a) - double(ref))/double(ulp);
+};
+
+//Time a function over the inputs (ns/call)
+template<typename T, typename F>
+double timeCalls(const std::vector<T> & x, F func, double & sink)
+{
+  const unsigned nRepeat = 20;
+  T sum(0.0);
+  auto t0 = std::chrono::high_resolution_clock::now();
+  for(unsigned R=0; R<nRepeat; R++)
+    for(unsigned I=0; I<x.size(); I++) sum = sum + func(x[I]);
+  auto t1 = std::chrono::high_resolution_clock::now();
+  sink = sink + double(primalValue(sum));
+  return std::chrono::duration<double,std::nano>(t1 - t0).count()/double(nRepeat*x.size());
+};
+
+//Each function, its generic kernel, <cmath>
+//reference, derivative and input range
+#define TCMATH_BENCH(FUNC, DFUNC, XMIN, XMAX)                                \
+struct bench_##FUNC{                                                          \
+  static constexpr const char *name = #FUNC;                                  \
+  static constexpr double xMin=XMIN, xMax=XMAX;                               \
+  template<typename T> static T kernel(const T x){return ::FUNC<T>(x);};      \
+  template<typename T> static T ref(const T x){return std::FUNC(x);};         \
+  static double dref(const double x){return DFUNC;};                          \
+  static dual_t overload(const dual_t x){return FUNC(x);};                    \
+};
+
+TCMATH_BENCH(exp,  std::exp(x),                  -50.0, 50.0)
+TCMATH_BENCH(expm1,std::exp(x),                  -1.0, 1.0)
+TCMATH_BENCH(log,  1.0/x,                          1e-3, 1e3)
+TCMATH_BENCH(sqrt, 0.5/std::sqrt(x),               1e-3, 1e3)
+TCMATH_BENCH(cbrt, 1.0/(3.0*std::cbrt(x*x)),      -1e3, 1e3)
+TCMATH_BENCH(sin,  std::cos(x),                  -100.0, 100.0)
+TCMATH_BENCH(cos, -std::sin(x),                  -100.0, 100.0)
+TCMATH_BENCH(tan,  1.0/(std::cos(x)*std::cos(x)), -1.5, 1.5)
+TCMATH_BENCH(atan, 1.0/(1.0 + x*x),              -20.0, 20.0)
+TCMATH_BENCH(asin, 1.0/std::sqrt(1.0 - x*x),     -0.99, 0.99)
+TCMATH_BENCH(acos,-1.0/std::sqrt(1.0 - x*x),     -0.99, 0.99)
+
+template<typename Bench, typename T>
+void runScalar(const unsigned nPts, double & sink)
+{
+  std::vector<T> x(nPts);
+  for(unsigned I=0; I<nPts; I++) x[I] = T(Bench::xMin + (Bench::xMax - Bench::xMin)*(I + 0.5)/nPts);
+
+  double maxUlp=0.0;
+  for(unsigned I=0; I<nPts; I++){
+    double ulp = ulpError<T>(Bench::template kernel<T>(x[I]), Bench::template ref<T>(x[I]));
+    maxUlp = (ulp > maxUlp)? ulp:maxUlp;
+  }
+  double tKernel = timeCalls(x, [](const T a){return Bench::template kernel<T>(a);}, sink);
+  double tRef    = timeCalls(x, [](const T a){return Bench::template ref<T>(a);}, sink);
+  std::printf("%-6s %-7s %12.2f %12.2f %14.2f\n", Bench::name
+             , (sizeof(T) == sizeof(double))? "double":"float", tKernel, tRef, maxUlp);
+};
+
+template<typename Bench>
+void runDual(const unsigned nPts, double & sink)
+{
+  std::vector<dual_t> x(nPts);
+  for(unsigned I=0; I<nPts; I++) x[I] = dual_t(Bench::xMin + (Bench::xMax - Bench::xMin)*(I + 0.5)/nPts, 1.0);
+
+  double maxUlp=0.0;
+  for(unsigned I=0; I<nPts; I++){
+    dual_t f = Bench::template kernel<dual_t>(x[I]);
+    double ulpVal  = ulpError<double>(f.val , Bench::template ref<double>(x[I].val));
+    double ulpGrad = ulpError<double>(f.grad, Bench::dref(x[I].val));
+    maxUlp = std::max(maxUlp, std::max(ulpVal, ulpGrad));
+  }
+  double tKernel   = timeCalls(x, [](const dual_t a){return Bench::template kernel<dual_t>(a);}, sink);
+  double tOverload = timeCalls(x, [](const dual_t a){return Bench::overload(a);}, sink);
+  std::printf("%-6s %-7s %12.2f %12.2f %14.2f\n", Bench::name, "dual", tKernel, tOverload, maxUlp);
+};
+
+template<typename Bench>
+void runAll(const unsigned nPts, double & sink)
+{
+  runScalar<Bench,double>(nPts, sink);
+  runScalar<Bench,float>(nPts, sink);
+  runDual<Bench>(nPts, sink);
+};
+
+int main(){
+  const unsigned nPts = 1 << 16;
+  double sink=0.0;
+
+  std::printf("%-6s %-7s %12s %12s %14s\n", "func", "type", "tCmath ns", "cmath ns", "max ULP");
+  std::printf("(dual rows: generic kernel ns, analytic overload ns)\n");
+  runAll<bench_exp>(nPts, sink);
+  runAll<bench_expm1>(nPts, sink);
+  runAll<bench_log>(nPts, sink);
+  runAll<bench_sqrt>(nPts, sink);
+  runAll<bench_cbrt>(nPts, sink);
+  runAll<bench_sin>(nPts, sink);
+  runAll<bench_cos>(nPts, sink);
+  runAll<bench_tan>(nPts, sink);
+  runAll<bench_atan>(nPts, sink);
+  runAll<bench_asin>(nPts, sink);
+  runAll<bench_acos>(nPts, sink);
+
+  //Keeps the timed loops alive
+  if(sink == 0.123456789) std::printf("%f\n", sink);
+  return 0;
+};
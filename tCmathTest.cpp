@@ -0,0 +1,462 @@
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+// Mathematical objects
+#include "include/templatedMathObjs/dualNumber.hpp"
+#include "include/templatedMathObjs/dualSimdNumber.hpp"
+#include "include/templatedMathObjs/dualVecNumber.hpp"
+#include "include/templatedMathObjs/dualHessNumber.hpp"
+#include "include/templatedMathObjs/tapeNumber.hpp"
+
+// Mathematical Functions
+#include "include/templatedMaths/tCmath.hpp"
+
+/*****************************************\
+!
+!  Checks of the templated maths kernels
+!  against <cmath> (values in ULP, the
+!  gradients of the dual numbers against
+!  the analytic derivative), the special
+!  values (zeros, infinities, NaN) and
+!  the edge cases of the range reductions
+!  returns the number of failed checks
+!
+\*****************************************/
+using dual_t  = dualNumber<double,double>;
+using dualf_t = dualNumber<float,float>;
+
+static int nFailed=0, nChecks=0;
+
+//Record a check (prints the failures)
+void check(const bool ok, const char *what, const double x, const double got, const double ref)
+{
+  nChecks++;
+  if(ok) return;
+  nFailed++;
+  std::printf("FAILED %-28s x = %-14.6g got %-22.15g ref %.15g\n", what, x, got, ref);
+};
+
+//Units in the last place of T
+template<typename T>
+double ulpError(const T a, const T ref)
+{
+  if(a == ref) return 0.0;
+  if(std::isnan(a) or std::isnan(ref)) return std::numeric_limits<double>::infinity();
+  const T absRef = std::fabs(ref);
+  const T ulp = std::nextafter(absRef, std::numeric_limits<T>::infinity()) - absRef;
+  return std::fabs(double(a) - double(ref))/double(ulp);
+};
+
+//Relative error (0 for equal values)
+double relError(const double a, const double ref)
+{
+  if(a == ref) return 0.0;
+  return std::fabs(a - ref)/std::fabs(ref);
+};
+
+//The same value, NaN or the same signed zero
+bool sameSpecial(const double a, const double ref)
+{
+  if(std::isnan(ref)) return std::isnan(a);
+  return (a == ref) and (std::signbit(a) == std::signbit(ref));
+};
+
+/*****************************************\
+!
+!  expm1, no cancellation for small |x|
+!
+\*****************************************/
+template<typename T>
+void testExpm1(const double maxUlp)
+{
+  const double xs[]={1e-300, 1e-20, 1e-10, -1e-8, 3e-5, -2e-3, 0.1, -0.2, 0.3, -0.34
+                   , 0.35, 0.4999, -0.5, 0.7, -1.0, 2.0, -5.0, 20.0, -30.0, 80.0};
+  for(double xd : xs){
+    const T x = T(xd);
+    check(ulpError<T>(::expm1<T>(x), std::expm1(x)) <= maxUlp, "expm1", xd, ::expm1<T>(x), std::expm1(x));
+  }
+  double worst=0.0;
+  for(int I=0; I<=200000; I++){
+    const T x = T(-40.0 + 120.0*I/200000.0);
+    const double ulp = ulpError<T>(::expm1<T>(x), std::expm1(x));
+    worst = (ulp > worst)? ulp:worst;
+  }
+  check(worst <= maxUlp, "expm1 sweep", 0.0, worst, maxUlp);
+  for(double xd : {1e-12, -0.25, 0.45, 3.0}){
+    dual_t f = ::expm1<dual_t>(dual_t(xd, 1.0));
+    check(relError(f.grad, std::exp(xd)) < 1e-14, "expm1 dual gradient", xd, f.grad, std::exp(xd));
+  }
+  check(::expm1<T>(T(-1000.0)) == T(-1.0), "expm1(-inf side)", -1000.0, ::expm1<T>(T(-1000.0)), -1.0);
+  check(std::isinf(::expm1<T>(T(1000.0))), "expm1(+inf side)", 1000.0, ::expm1<T>(T(1000.0)), INFINITY);
+};
+
+/*****************************************\
+!
+!  cbrt, range reduced over the whole
+!  (sub)normal range, both signs
+!
+\*****************************************/
+template<typename T>
+void testCbrt(const double maxUlp)
+{
+  const int eMin = std::numeric_limits<T>::min_exponent - std::numeric_limits<T>::digits;
+  const int eMax = std::numeric_limits<T>::max_exponent - 1;
+  double worst=0.0;
+  for(int e=eMin; e<eMax; e++){
+    for(double m : {1.0, 1.1, 1.37, 1.5, 1.83, 1.99}){
+      const T x = T(std::ldexp(m, e));
+      if((x == T(0.0)) or std::isinf(x)) continue;
+      for(T sx : {x, -x}){
+        const double ulp = ulpError<T>(::cbrt<T>(sx), std::cbrt(sx));
+        worst = (ulp > worst)? ulp:worst;
+        if(ulp > maxUlp) check(false, "cbrt", sx, ::cbrt<T>(sx), std::cbrt(sx));
+      }
+    }
+  }
+  check(worst <= maxUlp, "cbrt sweep", 0.0, worst, maxUlp);
+  check(sameSpecial(::cbrt<T>(T(0.0)), 0.0) and sameSpecial(::cbrt<T>(T(-0.0)), -0.0), "cbrt(+-0)", 0.0, ::cbrt<T>(T(-0.0)), -0.0);
+  check(std::isinf(::cbrt<T>(T(INFINITY))) and std::isnan(::cbrt<T>(T(NAN))), "cbrt(inf,nan)", INFINITY, ::cbrt<T>(T(INFINITY)), INFINITY);
+  for(double xd : {1e-9, -8.0, 27.5, 3e7}){
+    dual_t f = ::cbrt<dual_t>(dual_t(xd, 1.0));
+    const double ref = 1.0/(3.0*std::cbrt(xd)*std::cbrt(xd));
+    check(relError(f.grad, ref) < 1e-14, "cbrt dual gradient", xd, f.grad, ref);
+  }
+};
+
+/*****************************************\
+!
+!  x^(P/Q) for compile time P and Q (the
+!  scalar roots and the dual overloads)
+!  over several orders of magnitude, the
+!  odd roots of negative numbers and x = 0
+!
+\*****************************************/
+template<int P, int Q, typename T>
+void testPowPQ(const double tol)
+{
+  using dualT = dualNumber<T,T>;
+  constexpr double p = double(P)/double(Q);
+  const double sgnP = (P % 2 == 0)? 1.0:-1.0;
+  for(int e=-30; e<=30; e++){
+    for(double m : {1.0, 2.7, 5.5}){
+      for(double sx : {1.0, -1.0}){
+        if((sx < 0.0) and (Q % 2 == 0)) continue;
+        const T x = T(sx*m*std::pow(10.0, e));
+        const double ax = std::fabs(double(x));
+        const double ref  = ((sx < 0.0)? sgnP:1.0)*std::pow(ax, p);
+        const double dref = p*ref/double(x);
+        //Normal values and gradients of T only
+        const double vMin = std::numeric_limits<T>::min(), vMax = std::numeric_limits<T>::max();
+        if((std::fabs(ref) < vMin) or (std::fabs(ref) > vMax) or (std::fabs(dref) < vMin) or (std::fabs(dref) > vMax)) continue;
+        dualT f = pow<P,Q>(dualT(x, T(1.0)));
+        check(relError(pow<P,Q>(x), ref) < tol, "pow<P,Q> value", x, pow<P,Q>(x), ref);
+        check(relError(f.val , ref)  < tol, "pow<P,Q> dual value", x, f.val, ref);
+        check(relError(f.grad, dref) < tol, "pow<P,Q> dual gradient", x, f.grad, dref);
+      }
+    }
+  }
+  check(sameSpecial(pow<P,Q>(T(0.0)), (P > 0)? 0.0: INFINITY), "pow<P,Q>(0)", 0.0, pow<P,Q>(T(0.0)), (P > 0)? 0.0: INFINITY);
+};
+
+
+/*****************************************\
+!
+!  atan2, the four quadrants, the axes,
+!  the signed zeros and the infinities
+!
+\*****************************************/
+void testAtan2()
+{
+  const double vs[]={0.0, -0.0, 1e-300, -1e-300, 0.3, -0.3, 1.0, -1.0, 2.5, -2.5, 1e300, -1e300, INFINITY, -INFINITY};
+  for(double y : vs){
+    for(double x : vs){
+      const double got = ::atan2<double>(y, x), ref = std::atan2(y, x);
+      const bool ok = (got == ref)? (std::signbit(got) == std::signbit(ref)): (ulpError<double>(got, ref) <= 2.0);
+      check(ok, "atan2 (y,x=next)", y, got, ref);
+      if(not ok) std::printf("       x = %g\n", x);
+      const float gotF = ::atan2<float>(float(y), float(x)), refF = std::atan2(float(y), float(x));
+      check((gotF == refF) or (ulpError<float>(gotF, refF) <= 2.0), "atan2 float", y, gotF, refF);
+    }
+  }
+  check(std::isnan(::atan2<double>(NAN, 1.0)) and std::isnan(::atan2<double>(1.0, NAN)), "atan2(nan)", NAN, ::atan2<double>(NAN, 1.0), NAN);
+
+  //d atan2(y,x) = (x.dy - y.dx)/(x^2 + y^2)
+  //in every quadrant and on both branches
+  for(double y : {0.4, -0.4, 3.0, -3.0}){
+    for(double x : {0.5, -0.5, 2.0, -2.0}){
+      const double r2 = x*x + y*y;
+      dual_t fy = ::atan2<dual_t>(dual_t(y, 1.0), dual_t(x, 0.0));
+      dual_t fx = ::atan2<dual_t>(dual_t(y, 0.0), dual_t(x, 1.0));
+      check(relError(fy.val, std::atan2(y, x)) < 1e-15, "atan2 dual value", y, fy.val, std::atan2(y, x));
+      check(relError(fy.grad,  x/r2) < 1e-14, "atan2 dual d/dy", y, fy.grad,  x/r2);
+      check(relError(fx.grad, -y/r2) < 1e-14, "atan2 dual d/dx", y, fx.grad, -y/r2);
+    }
+  }
+};
+
+/*****************************************\
+!
+!  sin, cos and tan of non-finite
+!  values are NaN
+!
+\*****************************************/
+template<typename T>
+void testTrigNonFinite()
+{
+  for(double xd : {INFINITY, -INFINITY, NAN}){
+    const T x = T(xd);
+    check(std::isnan(::sin<T>(x)), "sin(non-finite)", xd, ::sin<T>(x), NAN);
+    check(std::isnan(::cos<T>(x)), "cos(non-finite)", xd, ::cos<T>(x), NAN);
+    check(std::isnan(::tan<T>(x)), "tan(non-finite)", xd, ::tan<T>(x), NAN);
+  }
+  dual_t s = ::sin<dual_t>(dual_t(INFINITY, 1.0));
+  check(std::isnan(s.val), "sin dual(inf)", INFINITY, s.val, NAN);
+  check(ulpError<T>(::sin<T>(T(1.0)), std::sin(T(1.0))) <= 1.0, "sin(1)", 1.0, ::sin<T>(T(1.0)), std::sin(1.0));
+};
+
+/*****************************************\
+!
+!  sin, cos and tan of large arguments,
+!  across the end of the Cody-Waite range
+!  up to the largest finite value, and
+!  the gradient of a dual past it
+!
+\*****************************************/
+template<typename T>
+void testTrigLarge(const double maxUlp, const double maxUlpTan)
+{
+  const double xMax = std::numeric_limits<T>::max();
+  const double xs[]={1e3, 5e3, 6e3, 7e3, 1e5, 1e6, 2e6, 1e8, 1e10, 1e16, 1e19, 1e20, 1e30, 3e38, 1e100, 1e300};
+  for(double xd : xs){
+    if(xd > xMax) continue;
+    for(const T x : {T(xd), T(-xd)}){
+      check(ulpError<T>(::sin<T>(x), std::sin(x)) <= maxUlp,    "sin(large)", x, ::sin<T>(x), std::sin(x));
+      check(ulpError<T>(::cos<T>(x), std::cos(x)) <= maxUlp,    "cos(large)", x, ::cos<T>(x), std::cos(x));
+      check(ulpError<T>(::tan<T>(x), std::tan(x)) <= maxUlpTan, "tan(large)", x, ::tan<T>(x), std::tan(x));
+    }
+  }
+  check(ulpError<T>(::sin<T>(T(xMax)), std::sin(T(xMax))) <= maxUlp, "sin(max)", xMax, ::sin<T>(T(xMax)), std::sin(T(xMax)));
+
+  //Log-spaced sweep over the whole range
+  double worst=0.0;
+  for(int I=0; I<=20000; I++){
+    const T x = T(std::exp(std::log(1e2) + (std::log(xMax) - std::log(1e2))*I/20000.0));
+    worst = std::max(worst, ulpError<T>(::sin<T>(x), std::sin(x)));
+    worst = std::max(worst, ulpError<T>(::cos<T>(x), std::cos(x)));
+  }
+  check(worst <= maxUlp, "sin/cos(large) sweep", 0.0, worst, maxUlp);
+
+  //The derivative path past the range
+  using dualT = dualNumber<T,T>;
+  const T x = T(1e16 < xMax? 1e16: 1e30);
+  const dualT s = ::sin<dualT>(dualT(x, T(1.0))), c = ::cos<dualT>(dualT(x, T(1.0)));
+  check(ulpError<T>(s.val, std::sin(x)) <= maxUlp, "sin dual(large)", x, s.val, std::sin(x));
+  check(ulpError<T>(s.grad, std::cos(x)) <= maxUlp, "sin dual(large) grad", x, s.grad, std::cos(x));
+  check(ulpError<T>(c.grad, -std::sin(x)) <= maxUlp, "cos dual(large) grad", x, c.grad, -std::sin(x));
+};
+
+/*****************************************\
+!
+!  The batched sin and cos (vector pass
+!  and the scalar out of range lanes)
+!  against <cmath>, small, large and
+!  non-finite arguments mixed in a batch
+!
+\*****************************************/
+template<typename T>
+void testBatchTrigLarge(const double maxUlp)
+{
+  const double xMax = std::numeric_limits<T>::max();
+  std::vector<T> x, ySin, yCos;
+  for(int I=0; I<=4000; I++){
+    const double xd = std::exp(std::log(1e-3) + (std::log(xMax) - std::log(1e-3))*I/4000.0);
+    x.push_back(T((I & 1)? -xd: xd));
+  }
+  for(double xd : {0.0, 6e3, 1e6, 1e8, 1e10, 1e16, 1e20, 1e300}) if(xd <= xMax) x.push_back(T(xd));
+  x.push_back(T(INFINITY));
+  x.push_back(T(NAN));
+  ySin.resize(x.size());
+  yCos.resize(x.size());
+  ::sin(tSpan<const T>(x.data(), x.size()), tSpan<T>(ySin.data(), ySin.size()));
+  ::cos(tSpan<const T>(x.data(), x.size()), tSpan<T>(yCos.data(), yCos.size()));
+
+  double worst=0.0;
+  bool special=true;
+  for(std::size_t I=0; I<x.size(); I++){
+    if(std::isfinite(x[I])){
+      worst = std::max(worst, ulpError<T>(ySin[I], std::sin(x[I])));
+      worst = std::max(worst, ulpError<T>(yCos[I], std::cos(x[I])));
+    }else{
+      special = special and std::isnan(ySin[I]) and std::isnan(yCos[I]);
+    }
+  }
+  check(worst <= maxUlp, "batched sin/cos(large)", 0.0, worst, maxUlp);
+  check(special, "batched sin/cos(non-finite)", 0.0, 0.0, 0.0);
+};
+
+/*****************************************\
+!
+!  Integer literals mixed with the packed
+!  dual numbers (int, unsigned, long
+!  promote to double)
+!
+\*****************************************/
+template<typename v_t>
+void testDualSimdIntegers()
+{
+  using simd_t = dualSimdNumber<v_t,5>;
+  const double tol = std::is_same<v_t,float>::value? 1e-6: 1e-15;
+  const double x0 = 0.7;
+  simd_t x(v_t(x0), 2u);
+
+  //f = (2x + 1)(x - 3)/4 + 1/x - (5 - x)/2 + 3u*exp(x*2L)
+  simd_t f = (2*x + 1)*(x - 3)/4 + 1/x - (5 - x)/2 + 3u*exp(x*2L);
+  f += 1;  f -= 2u;  f *= 3;  f /= 6L;
+  const double fRef  = ((2*x0 + 1)*(x0 - 3)/4 + 1/x0 - (5 - x0)/2 + 3*std::exp(2*x0) - 1)/2;
+  const double dfRef = ((4*x0 - 5)/4 - 1/(x0*x0) + 0.5 + 6*std::exp(2*x0))/2;
+  check(relError(f.val, fRef) < tol, "dualSimd int literals", x0, f.val, fRef);
+  check(relError(f.grad[2], dfRef) < tol, "dualSimd int gradient", x0, f.grad[2], dfRef);
+  bool zeroLanes=true;
+  for(unsigned I=0; I<simd_t::nPad; I++) zeroLanes = zeroLanes and ((I == 2) or (f.grad[I] == v_t(0.0)));
+  check(zeroLanes, "dualSimd int other lanes", x0, 0.0, 0.0);
+};
+
+/*****************************************\
+!
+!  Integer literals in a polynomial of
+!  the Hessian-lane numbers (tHessian),
+!  against the analytic gradient and
+!  Hessian
+!
+\*****************************************/
+template<typename T>
+void testHessIntegers(const double tol)
+{
+  const T x0[2]={T(0.7), T(-1.3)};
+  T dF[2], d2F[4];
+  const T F = tHessian<2>([](const auto x[]){
+    //f = 3x^2.y - x/2 + 2(1 - y) + 4/x + (x.y + 1)/3
+    auto f = 3*x[0]*x[0]*x[1] - x[0]/2 + (1 - x[1])*2u + 4L/x[0] + (x[0]*x[1] + 1)/3;
+    f += 1;  f *= 2;  f -= 3u;  f /= 4L;
+    return f;
+  }, x0, dF, d2F);
+
+  const double x = x0[0], y = x0[1];
+  const double f   = 3*x*x*y - x/2 + 2*(1 - y) + 4/x + (x*y + 1)/3;
+  const double ref[7]={f/2 - 0.25
+                     , (6*x*y - 0.5 - 4/(x*x) + y/3)/2, (3*x*x - 2 + x/3)/2
+                     , (6*y + 8/(x*x*x))/2, (6*x + 1.0/3.0)/2, (6*x + 1.0/3.0)/2, 0.0};
+  const T got[7]={F, dF[0], dF[1], d2F[0], d2F[1], d2F[2], d2F[3]};
+  for(unsigned I=0; I<7; I++){
+    check(std::fabs(got[I] - ref[I]) <= tol*std::max(1.0, std::fabs(ref[I])), "dualHess int literals", I, got[I], ref[I]);
+  }
+};
+
+/*****************************************\
+!
+!  Reverse mode (tapeNumber) against the
+!  forward mode (dualVecNumber) on a 3D
+!  neo-Hookean density of F [3 x 3] with
+!  integer literals and a log term
+!
+\*****************************************/
+struct tNeoHookeanTestEnergy
+{
+  double mu=1.0, K=10.0;
+
+  template<typename T>
+  T operator()(const T F[]) const
+  {
+    T detF = F[0]*(F[4]*F[8] - F[5]*F[7])
+           - F[1]*(F[3]*F[8] - F[5]*F[6])
+           + F[2]*(F[3]*F[7] - F[4]*F[6]);
+    T FF(0.0);
+    for(unsigned I=0; I<9; I++) FF += F[I]*F[I];
+    return (mu/2)*(pow<-2,3>(detF)*FF - 3) + (K/2)*(detF - 1)*(detF - 1) - mu*log(detF)/3;
+  };
+};
+
+template<typename T>
+void testTapeGradient(const double tol)
+{
+  const tNeoHookeanTestEnergy W;
+  const T F[9]={T(1.1), T(0.05), T(-0.02), T(0.03), T(0.95), T(0.04), T(-0.01), T(0.02), T(1.05)};
+  T dWTape[9], dWDual[9];
+  tapeReserve<T>(256);
+  const T wTape = tAdjointGradient<T>([&](const auto x[]){return W(x);}, F, dWTape, 9);
+  const T wDual = tGradient<9>([&](const auto x[]){return W(x);}, F, dWDual);
+  check(relError(wTape, wDual) < tol, "tape value", 0.0, wTape, wDual);
+  for(unsigned I=0; I<9; I++) check(relError(dWTape[I], dWDual[I]) < tol, "tape gradient", I, dWTape[I], dWDual[I]);
+
+  //Integer literals on the taped numbers
+  tapeNumber<T> x(T(0.7));
+  const tapeNumber<T> y = (2*x + 1)/3 - (1 - x)*2u + 4L/x;
+  const double yRef = (2*0.7 + 1)/3 - (1 - 0.7)*2 + 4/0.7;
+  check(relError(y.val, yRef) < tol, "tape int literals", 0.7, y.val, yRef);
+};
+
+/*****************************************\
+!
+!  Nested duals of vector duals, each
+!  member expression is fused by the
+!  dualVecNumber expression templates
+!  f = x.y + x/y - 2x, d/dx and d/dy
+!  (lanes) and the directional d/dx
+!
+\*****************************************/
+void testNestedVecDual()
+{
+  using vec_t = dualVecNumber<double,2>;
+  using nest_t = dualNumber<vec_t,vec_t>;
+  const double x0=1.5, y0=0.5;
+  nest_t x(vec_t(x0, 0u), vec_t(1.0)), y(vec_t(y0, 1u), vec_t(0.0));
+  nest_t f = x*y + x/y - 2.0*x;
+  const double fRef = x0*y0 + x0/y0 - 2*x0;
+  const double dfdx = y0 + 1/y0 - 2, dfdy = x0 - x0/(y0*y0);
+  check(relError(f.val.val, fRef) < 1e-15, "nested value", x0, f.val.val, fRef);
+  check(relError(f.val.grad[0], dfdx) < 1e-15, "nested lane d/dx", x0, f.val.grad[0], dfdx);
+  check(relError(f.val.grad[1], dfdy) < 1e-15, "nested lane d/dy", x0, f.val.grad[1], dfdy);
+  check(relError(f.grad.val, dfdx) < 1e-15, "nested directional", x0, f.grad.val, dfdx);
+
+  //d2f/dxdy = 1 - 1/y^2 (the lane of
+  //the directional derivative)
+  const double d2fdxdy = 1 - 1/(y0*y0);
+  check(relError(f.grad.grad[1], d2fdxdy) < 1e-15, "nested d2f/dxdy", x0, f.grad.grad[1], d2fdxdy);
+};
+
+int main(){
+  testExpm1<double>(1.0);
+  testExpm1<float>(1.0);
+  testCbrt<double>(2.0);
+  testCbrt<float>(2.0);
+  testPowPQ<1,3,float>(1e-6);
+  testPowPQ<-2,3,float>(1e-6);
+  testPowPQ<2,3,float>(1e-6);
+  testPowPQ<1,5,float>(1e-6);
+  testPowPQ<-3,5,float>(1e-6);
+  testPowPQ<3,2,float>(1e-6);
+  testPowPQ<-1,4,float>(1e-6);
+  testPowPQ<1,3,double>(1e-14);
+  testPowPQ<-2,3,double>(1e-14);
+  testPowPQ<1,5,double>(1e-14);
+  testPowPQ<-3,7,double>(1e-14);
+  testAtan2();
+  testTrigNonFinite<double>();
+  testTrigNonFinite<float>();
+  testTrigLarge<double>(2.0, 4.0);
+  testTrigLarge<float>(2.0, 4.0);
+  testBatchTrigLarge<double>(2.0);
+  testBatchTrigLarge<float>(2.0);
+  testDualSimdIntegers<double>();
+  testDualSimdIntegers<float>();
+  testHessIntegers<double>(1e-14);
+  testHessIntegers<float>(1e-5);
+  testTapeGradient<double>(1e-14);
+  testTapeGradient<float>(1e-5);
+  testNestedVecDual();
+
+  std::printf("%d/%d checks passed\n", nChecks - nFailed, nChecks);
+  return nFailed;
+};
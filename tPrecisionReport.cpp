@@ -0,0 +1,136 @@
+#include <iostream>
+#include <cstdio>
+#include <vector>
+#include <cmath>
+#include "mfem.hpp"
+#include "include/nlOperator/tADNonLinearForm.hpp"
+
+// Energy functionals
+#include "include/energyFunctional/neoHookeanTCoeff.hpp"
+
+/*****************************************\
+!
+!  Residual accuracy of the precision
+!  pairs of tADNLForm<Number,AccumNumber>
+!  on the neo-Hookean residual of the
+!  deformed positions (vector H1, order 2)
+!  of a unit square of nx x nx quads with a
+!  rigid translation of 10 (the sampled
+!  position gradients cancel it), the
+!  forms evaluated:
+!   REAL64/REAL64 (the reference)
+!   REAL32/REAL64 (tADNLFormMixed)
+!   REAL32/REAL32
+!  the residual errors (max and l2) are
+!  relative to the reference residual,
+!  the Jacobian actions and the energies
+!  are compared in the same way
+!
+\*****************************************/
+//Deformed positions, a stretch and a
+//twist on top of a rigid translation
+void deform(const Vector & X, Vector & x)
+{
+  x = X;
+  x(0) += 10.0 + 0.05*X(0) + 0.02*std::sin(X(1));
+  x(1) += 10.0 + 0.03*X(1) - 0.02*std::sin(X(0));
+};
+
+//The neo-Hookean form of a precision pair
+template<typename Number, typename AccumNumber>
+tADNLForm<Number,AccumNumber> * makeForm(const std::vector<ParGridFunction*> & gFuncs, const IntegrationRule & ir
+                                       , const mfem::DenseMatrix & gradInterp, const mfem::Device & device
+                                       , const mfem::MemoryType & mt, const bool & use_dev)
+{
+  tADNLForm<Number,AccumNumber> *form = new tADNLForm<Number,AccumNumber>(gFuncs, device, mt, use_dev);
+  const unsigned integID = form->AddIntegRule(ir);
+  form->AddTVar(Var<int>{0, 2, {2, 2}}, gradInterp);
+  form->AddEnergy(TNeoHookeanCoeffIntegrator<Number,2>(mfem::Array<int>({0}), integID, 1.0, 10.0));
+  form->PrepareOperator();
+  return form;
+};
+
+//The max and l2 norms of y - yRef
+//relative to those of yRef
+void relErrors(const Vector & y, const Vector & yRef, double & errMax, double & errL2)
+{
+  mfem::Vector diff(y);
+  diff -= yRef;
+  double maxs[2] = {diff.Normlinf(), yRef.Normlinf()};
+  MPI_Allreduce(MPI_IN_PLACE, maxs, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  errMax = maxs[0]/maxs[1];
+  errL2  = std::sqrt(InnerProduct(MPI_COMM_WORLD, diff, diff)/InnerProduct(MPI_COMM_WORLD, yRef, yRef));
+};
+
+template<typename Number, typename AccumNumber>
+void report(const char *name, tADNLForm<Number,AccumNumber> & form, const Vector & x, const Vector & v
+          , const Vector & yRef, const Vector & JvRef, const real_t eRef, const long long nElms)
+{
+  mfem::Vector y(x.Size()), Jv(x.Size());
+  form.Mult(x,y);
+  form.GetGradient(x).Mult(v,Jv);
+  const real_t e = form.GetEnergy(x);
+
+  double errMax, errL2, errJMax, errJL2;
+  relErrors(y, yRef, errMax, errL2);
+  relErrors(Jv, JvRef, errJMax, errJL2);
+  if(Mpi::WorldRank() == 0){
+    std::printf("%-8lld %-15s %14.3e %14.3e %14.3e %14.3e\n", nElms, name, errMax, errL2, errJL2
+              , double(std::fabs(e - eRef)/std::fabs(eRef)));
+  }
+};
+
+void compare(const int nx)
+{
+  mfem::Device device("cpu");
+  const mfem::MemoryType mt = device.GetMemoryType();
+  const bool use_dev=false;
+  const int order=2;
+
+  // 1. The mesh and the deformed positions
+  Mesh mesh = Mesh::MakeCartesian2D(nx, nx, Element::QUADRILATERAL, true, 1.0, 1.0);
+  ParMesh pmesh(MPI_COMM_WORLD, mesh);
+  H1_FECollection fec(order, 2);
+  ParFiniteElementSpace fespace(&pmesh, &fec, 2);
+  std::vector<mfem::ParGridFunction*> gFuncs{new mfem::ParGridFunction(&fespace)};
+  VectorFunctionCoefficient deformed(2, deform);
+  gFuncs[0]->ProjectCoefficient(deformed);
+
+  const int NEQs = fespace.GetTrueVSize();
+  mfem::Vector x(NEQs,mt), v(NEQs,mt), yRef(NEQs,mt), JvRef(NEQs,mt);
+  gFuncs[0]->GetTrueDofs(x);
+  v = x;
+  const IntegrationRule & ir = IntRules.Get(pmesh.GetElementBaseGeometry(0), 2*order + 3);
+  mfem::DenseMatrix gradInterp;
+  tInterpolator::ShapeGrads(*fespace.GetFE(0), 2, ir, gradInterp);
+
+  // 2. The reference (double) form
+  tADNLForm<REAL64,REAL64> *ref = makeForm<REAL64,REAL64>(gFuncs, ir, gradInterp, device, mt, use_dev);
+  ref->Mult(x,yRef);
+  ref->GetGradient(x).Mult(v,JvRef);
+  const real_t eRef = ref->GetEnergy(x);
+  const long long nElms = pmesh.GetGlobalNE();
+  delete ref;
+
+  // 3. The float evaluations
+  tADNLFormMixed *mixed = makeForm<REAL32,REAL64>(gFuncs, ir, gradInterp, device, mt, use_dev);
+  report("float/double", *mixed, x, v, yRef, JvRef, eRef, nElms);
+  delete mixed;
+
+  tADNLForm<REAL32,REAL32> *single = makeForm<REAL32,REAL32>(gFuncs, ir, gradInterp, device, mt, use_dev);
+  report("float/float", *single, x, v, yRef, JvRef, eRef, nElms);
+  delete single;
+
+  delete gFuncs[0];
+};
+
+int main(){
+  Mpi::Init();
+  Hypre::Init();
+  if(Mpi::WorldRank() == 0){
+    std::printf("%-8s %-15s %14s %14s %14s %14s\n", "nElms", "Number/Accum", "max rel err", "l2 rel err"
+              , "J.v l2 rel err", "e rel err");
+  }
+  for(int nx : {8, 32, 128}) compare(nx);
+  return 0;
+};